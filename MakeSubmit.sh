@@ -4,6 +4,7 @@ WorkDir=/afs/cern.ch/user/c/chenyi/work/Temp/21413_JetToyHI/JetToyHI
 OutputDir=$WorkDir/SignalOnly
 SampleBase=$WorkDir/Samples/jewel_20190515_Raghav
 SubmitFile=Submit.condor
+ShardCount=1   # > 1: split each file into this many jobs (uses the event index)
 
 rm $SubmitFile
 echo WorkDir    = $WorkDir               >> $SubmitFile
@@ -20,11 +21,22 @@ for file in `ls $SampleBase |  grep wRecoil`
 do
    echo $file
 
-   echo Arguments = $\(WorkDir\) $\(SampleBase\)/$file $\(OutputDir\)/${file/.pu14/.root}  >> $SubmitFile
-   echo Output    = Log/out.$\(Process\)                                                   >> $SubmitFile
-   echo Error     = Log/err.$\(Process\)                                                   >> $SubmitFile
-   echo Log       = Log/log.$\(Process\)                                                   >> $SubmitFile
-   echo Queue                                                                              >> $SubmitFile
+   for shard in `seq 0 $((ShardCount - 1))`
+   do
+      if [[ $ShardCount == 1 ]]; then
+         Output=${file/.pu14/.root}
+         Options=
+      else
+         Output=${file/.pu14/_Shard$shard.root}
+         Options="-shard $shard/$ShardCount"
+      fi
+
+      echo Arguments = \"$\(WorkDir\) $\(SampleBase\)/$file $\(OutputDir\)/$Output \'$Options\'\"  >> $SubmitFile
+      echo Output    = Log/out.$\(Process\)                                                   >> $SubmitFile
+      echo Error     = Log/err.$\(Process\)                                                   >> $SubmitFile
+      echo Log       = Log/log.$\(Process\)                                                   >> $SubmitFile
+      echo Queue                                                                              >> $SubmitFile
+   done
 done
 
 
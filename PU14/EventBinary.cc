@@ -0,0 +1,53 @@
+#include "EventBinary.hh"
+#include "PU14.hh"
+#include <cstring>
+
+using namespace std;
+using namespace fastjet;
+
+//----------------------------------------------------------------------
+BinaryEventWriter::BinaryEventWriter(const std::string & filename)
+   : _out(filename.c_str(), ios::out | ios::binary), _event_count(0) {
+   PU14Binary::FileHeader header;
+   memcpy(header.magic, PU14Binary::Magic, sizeof(header.magic));
+   header.version = PU14Binary::Version;
+   header.flags   = 0;
+   _out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+//----------------------------------------------------------------------
+void BinaryEventWriter::write_event(const std::vector<fastjet::PseudoJet> & particles,
+      double event_weight) {
+   uint32_t n = particles.size();
+
+   PU14Binary::EventHeader header;
+   header.n        = n;
+   header.reserved = 0;
+   header.weight   = event_weight;
+
+   // fill the columns: px, py, pz, m followed by pdgid, vertex
+   _momenta.resize(4 * n);
+   _ids.resize(2 * n);
+   for (unsigned i = 0; i < n; i++) {
+      const PseudoJet & p = particles[i];
+      _momenta[i]       = p.px();
+      _momenta[n + i]   = p.py();
+      _momenta[2*n + i] = p.pz();
+      _momenta[3*n + i] = p.m();
+      const PU14 * info = pu14_info_ptr(p);
+      if (info) {
+         _ids[i]     = info->pdg_id();
+         _ids[n + i] = info->vertex();
+      } else {
+         _ids[i]     = 0;
+         _ids[n + i] = 0;
+      }
+   }
+
+   _out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+   if (n > 0) {
+      _out.write(reinterpret_cast<const char *>(&_momenta[0]), _momenta.size() * sizeof(float));
+      _out.write(reinterpret_cast<const char *>(&_ids[0]), _ids.size() * sizeof(int32_t));
+   }
+   _event_count++;
+}
@@ -0,0 +1,75 @@
+#ifndef __EVENTBINARY_HH__
+#define __EVENTBINARY_HH__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "fastjet/PseudoJet.hh"
+
+//----------------------------------------------------------------------
+/// Compact binary version of the PU14 event format.  It carries the
+/// same information as the text format (px, py, pz, m, pdgid, vertex
+/// and the event weight) but can be read back without any parsing.
+///
+/// Layout (numbers in the byte order of the machine that wrote them):
+///
+///   file header : char magic[8] = "PU14BIN", uint32 version, uint32 flags
+///   each event  : uint32 n, uint32 reserved, double weight,
+///                 float px[n], float py[n], float pz[n], float m[n],
+///                 int32 pdgid[n], int32 vertex[n]
+///
+/// All blocks are multiples of 4 bytes, so the columns of a mapped
+/// file can be accessed in place.
+namespace PU14Binary {
+   const char     Magic[8] = {'P', 'U', '1', '4', 'B', 'I', 'N', '\0'};
+   const uint32_t Version  = 1;
+
+   struct FileHeader {
+      char     magic[8];
+      uint32_t version;
+      uint32_t flags;
+   };
+
+   struct EventHeader {
+      uint32_t n;
+      uint32_t reserved;
+      double   weight;
+   };
+
+   /// number of float/int columns stored per particle
+   const int ColumnCount = 6;
+
+   /// size in bytes of an event block with n particles
+   inline size_t event_size(uint32_t n) {
+      return sizeof(EventHeader) + size_t(n) * ColumnCount * 4;
+   }
+}
+
+//----------------------------------------------------------------------
+/// \class BinaryEventWriter
+///
+/// Writes events in the PU14Binary format.  The pdg id and vertex are
+/// taken from the PU14 user info of each particle (0 if absent).
+class BinaryEventWriter {
+public:
+   BinaryEventWriter(const std::string & filename);
+
+   /// returns false if the output file could not be written
+   bool good() const {return _out.good();}
+
+   /// appends one event to the file
+   void write_event(const std::vector<fastjet::PseudoJet> & particles,
+         double event_weight);
+
+   /// number of events written so far
+   int event_count() const {return _event_count;}
+
+private:
+   std::ofstream _out;
+   std::vector<float> _momenta;
+   std::vector<int32_t> _ids;
+   int _event_count;
+};
+
+#endif // __EVENTBINARY_HH__
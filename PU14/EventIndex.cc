@@ -0,0 +1,209 @@
+#include "EventIndex.hh"
+#include "EventBinary.hh"
+#include "MappedFile.hh"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// layout of the side-car file: header, Entry[event_count],
+// RestartPoint[point_count], all in the byte order of the machine that
+// wrote it
+namespace {
+   const char     IndexMagic[8] = {'P', 'U', '1', '4', 'I', 'D', 'X', '\0'};
+   const uint32_t IndexVersion  = 1;
+
+   struct IndexHeader {
+      char     magic[8];
+      uint32_t version;
+      uint32_t format;
+      uint64_t file_size;
+      uint64_t file_time;
+      uint64_t event_count;
+      uint64_t point_count;
+   };
+
+   /// true if [begin, end) is a HepMC record of the given type (a single
+   /// letter followed by whitespace)
+   bool is_record(const char * begin, const char * end, char type) {
+      if (begin == end || begin[0] != type) return false;
+      return (end - begin == 1 || begin[1] == ' ' || begin[1] == '\t');
+   }
+}
+
+//----------------------------------------------------------------------
+uint32_t EventIndex::_format_code(const std::string & type) {
+   if (type == "PU14" || type == "PU14Stream") return 1;
+   if (type == "PU14Binary") return 2;
+   if (type == "HepMC2") return 3;
+   if (type == "HepMC3") return 4;
+   return 0;
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::_file_stamp(const std::string & filename, uint64_t & size, uint64_t & time) {
+   struct stat info;
+   if (stat(filename.c_str(), &info) != 0) return false;
+   size = info.st_size;
+   time = info.st_mtime;
+   return true;
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::build(const std::string & filename, const std::string & type) {
+   _events.clear();
+   _points.clear();
+   _format = _format_code(type);
+   if (_format == 0) {
+      cerr << "ERROR: cannot index files of type " << type << endl;
+      return false;
+   }
+   if (!_file_stamp(filename, _file_size, _file_time)) return false;
+
+   if (_format == 2) return _build_binary(filename);
+   return _build_text(filename);
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::_build_text(const std::string & filename) {
+   TextSource text;
+   if (!text.open(filename)) return false;
+   text.record_restart_points(&_points, RestartSpan);
+
+   bool hepmc = (_format == 3 || _format == 4);
+   Entry entry = {0, 0, 0};
+   bool in_event = !hepmc;   // HepMC files have a header before the first E line
+
+   const char *begin, *end;
+   uint64_t offset = text.offset();
+   while (text.next_line(begin, end)) {
+      if (hepmc) {
+         // an event runs from its E line to the next one
+         if (is_record(begin, end, 'E')) {
+            if (in_event) _events.push_back(entry);
+            entry.offset = offset;
+            entry.particle_count = 0;
+            in_event = true;
+         } else if (is_record(begin, end, 'P')) {
+            entry.particle_count++;
+         }
+      } else {
+         // same rules as EventSource::append_next_event_pu14
+         if (begin == end || begin[0] == '#') {
+         } else if (begin[0] == 'e' && end - begin >= 3 && strncmp(begin, "end", 3) == 0) {
+            _events.push_back(entry);
+            entry.particle_count = 0;
+            entry.offset = text.offset();
+         } else if (begin[0] == 'w' && end - begin >= 6 && strncmp(begin, "weight", 6) == 0) {
+         } else {
+            entry.particle_count++;
+         }
+      }
+      offset = text.offset();
+   }
+
+   // an unterminated last PU14 event is still read by EventSource
+   if (!hepmc && entry.particle_count > 0) _events.push_back(entry);
+   return true;
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::_build_binary(const std::string & filename) {
+   MappedFile mapped;
+   if (!mapped.open(filename)) return false;
+
+   size_t offset = sizeof(PU14Binary::FileHeader);
+   PU14Binary::EventHeader header;
+   while (offset + sizeof(header) <= mapped.size()) {
+      memcpy(&header, mapped.data() + offset, sizeof(header));
+      if (offset + PU14Binary::event_size(header.n) > mapped.size()) break;
+      Entry entry = {offset, header.n, 0};
+      _events.push_back(entry);
+      offset += PU14Binary::event_size(header.n);
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::save(const std::string & indexname) const {
+   IndexHeader header;
+   memcpy(header.magic, IndexMagic, sizeof(header.magic));
+   header.version     = IndexVersion;
+   header.format      = _format;
+   header.file_size   = _file_size;
+   header.file_time   = _file_time;
+   header.event_count = _events.size();
+   header.point_count = _points.size();
+
+   // write under a temporary name, so that jobs starting at the same
+   // time never see a half-written index
+   ostringstream tempname_stream;
+   tempname_stream << indexname << ".tmp" << getpid();
+   string tempname = tempname_stream.str();
+   {
+      ofstream out(tempname.c_str(), ios::out | ios::binary);
+      out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      if (!_events.empty())
+         out.write(reinterpret_cast<const char *>(&_events[0]), _events.size() * sizeof(Entry));
+      if (!_points.empty())
+         out.write(reinterpret_cast<const char *>(&_points[0]),
+               _points.size() * sizeof(TextSource::RestartPoint));
+      if (!out.good()) {
+         remove(tempname.c_str());
+         return false;
+      }
+   }
+   return rename(tempname.c_str(), indexname.c_str()) == 0;
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::load(const std::string & indexname, const std::string & filename,
+      const std::string & type) {
+   uint64_t size, time;
+   if (!_file_stamp(filename, size, time)) return false;
+
+   ifstream in(indexname.c_str(), ios::in | ios::binary);
+   IndexHeader header;
+   if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+   if (memcmp(header.magic, IndexMagic, sizeof(header.magic)) != 0
+         || header.version != IndexVersion
+         || header.format != _format_code(type)
+         || header.file_size != size || header.file_time != time)
+      return false;
+
+   _events.resize(header.event_count);
+   _points.resize(header.point_count);
+   if (!_events.empty())
+      in.read(reinterpret_cast<char *>(&_events[0]), _events.size() * sizeof(Entry));
+   if (!_points.empty())
+      in.read(reinterpret_cast<char *>(&_points[0]),
+            _points.size() * sizeof(TextSource::RestartPoint));
+   if (!in) {
+      _events.clear();
+      _points.clear();
+      return false;
+   }
+
+   _format = header.format;
+   _file_size = size;
+   _file_time = time;
+   return true;
+}
+
+//----------------------------------------------------------------------
+bool EventIndex::load_or_build(const std::string & filename, const std::string & type) {
+   string indexname = default_name(filename);
+   if (load(indexname, filename, type)) return true;
+
+   cerr << "INFO: indexing " << filename << endl;
+   if (!build(filename, type)) return false;
+   // not being able to save (e.g. read-only sample area) is not fatal
+   if (!save(indexname))
+      cerr << "WARNING: could not write the event index " << indexname << endl;
+   return true;
+}
@@ -0,0 +1,82 @@
+#ifndef __EVENTINDEX_HH__
+#define __EVENTINDEX_HH__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "TextSource.hh"
+
+//----------------------------------------------------------------------
+/// \class EventIndex
+///
+/// Byte offset and particle count of every event in an event file, so
+/// that EventSource can jump straight to event N instead of parsing all
+/// the events before it.  It is built by reading the file once and kept
+/// next to it as a side-car file (filename + ".idx"), which is rebuilt
+/// when the size or modification time of the event file changes.
+///
+/// For gzipped files the offsets are positions in the uncompressed
+/// text, and the index also stores a decompressor restart point every
+/// RestartSpan bytes of text (32 kB each), so a seek only decompresses
+/// up to RestartSpan bytes.
+///
+/// The events are counted the way EventSource returns them: for HepMC
+/// an event starts at its E line and the last one in the file (which is
+/// not followed by another E line) is not included; the particle count
+/// is the number of particle lines/records in the file.
+class EventIndex {
+public:
+   /// text between two restart points of a gzipped file
+   static const uint64_t RestartSpan = 16 << 20;
+
+   struct Entry {
+      uint64_t offset;
+      uint32_t particle_count;
+      uint32_t reserved;
+   };
+
+   EventIndex() : _format(0), _file_size(0), _file_time(0) {}
+
+   /// reads the whole event file (type as in EventSource: PU14,
+   /// PU14Binary, HepMC2 or HepMC3) and records where each event
+   /// starts; returns false if the file cannot be read
+   bool build(const std::string & filename, const std::string & type);
+
+   /// saves the index to / loads it from the given file.  load() fails
+   /// if the index was made for another type or does not match the
+   /// current state of filename.
+   bool save(const std::string & indexname) const;
+   bool load(const std::string & indexname, const std::string & filename,
+         const std::string & type);
+
+   /// loads the side-car index of filename, building and saving it
+   /// first if it is missing or out of date
+   bool load_or_build(const std::string & filename, const std::string & type);
+
+   /// name of the side-car index of an event file
+   static std::string default_name(const std::string & filename) {return filename + ".idx";}
+
+   size_t event_count() const {return _events.size();}
+   const Entry & event(size_t i) const {return _events[i];}
+
+   /// restart points for gzipped files (empty otherwise)
+   const std::vector<TextSource::RestartPoint> & restart_points() const {return _points;}
+
+private:
+   bool _build_text(const std::string & filename);
+   bool _build_binary(const std::string & filename);
+
+   /// number stored in the index for each file type (0 if unsupported)
+   static uint32_t _format_code(const std::string & type);
+
+   /// size and modification time of filename, to detect stale indices
+   static bool _file_stamp(const std::string & filename, uint64_t & size, uint64_t & time);
+
+   std::vector<Entry> _events;
+   std::vector<TextSource::RestartPoint> _points;
+   uint32_t _format;
+   uint64_t _file_size;
+   uint64_t _file_time;
+};
+
+#endif // __EVENTINDEX_HH__
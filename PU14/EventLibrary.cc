@@ -0,0 +1,66 @@
+#include "EventLibrary.hh"
+#include "EventSource.hh"
+#include "PU14.hh"
+#include <iostream>
+
+using namespace std;
+using namespace fastjet;
+
+//----------------------------------------------------------------------
+bool EventLibrary::load(const std::string & filename, const std::string & type, int max_events) {
+   _start.assign(1, 0);
+   _weight.clear();
+   _px.clear(); _py.clear(); _pz.clear(); _m.clear();
+   _pdgid.clear(); _vertex.clear();
+
+   EventSource source(filename, type);
+   vector<PseudoJet> particles;
+   double weight = 1;
+   while ((max_events < 0 || int(_weight.size()) < max_events)
+          && source.append_next_event(particles, weight)) {
+      for (unsigned i = 0; i < particles.size(); i++) {
+         const PseudoJet & p = particles[i];
+         _px.push_back(p.px());
+         _py.push_back(p.py());
+         _pz.push_back(p.pz());
+         _m.push_back(p.m());
+         const PU14 * info = pu14_info_ptr(p);
+         if (info) {
+            _pdgid.push_back(info->pdg_id());
+            _vertex.push_back(info->vertex());
+         } else {
+            _pdgid.push_back(0);
+            _vertex.push_back(0);
+         }
+      }
+      _weight.push_back(weight);
+      _start.push_back(_pdgid.size());
+      particles.clear();
+   }
+
+   // give back what the doubling of the vectors left over
+   vector<float>(_px).swap(_px);
+   vector<float>(_py).swap(_py);
+   vector<float>(_pz).swap(_pz);
+   vector<float>(_m).swap(_m);
+   vector<int32_t>(_pdgid).swap(_pdgid);
+   vector<int32_t>(_vertex).swap(_vertex);
+
+   cerr << "INFO: loaded " << event_count() << " events (" << particle_count()
+        << " particles) from " << filename << " into memory" << endl;
+   return event_count() > 0;
+}
+
+//----------------------------------------------------------------------
+void EventLibrary::append_event(size_t i, std::vector<fastjet::PseudoJet> & particles,
+      double & event_weight) const {
+   event_weight = _weight[i];
+
+   for (size_t j = _start[i]; j < _start[i + 1]; j++) {
+      double x = _px[j], y = _py[j], z = _pz[j], mass = _m[j];
+      PseudoJet particle(x, y, z, sqrt(x*x + y*y + z*z + mass*mass));
+
+      set_pu14_info(particle, _pdgid[j], _vertex[j]);
+      particles.push_back(particle);
+   }
+}
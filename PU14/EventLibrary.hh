@@ -0,0 +1,43 @@
+#ifndef __EVENTLIBRARY_HH__
+#define __EVENTLIBRARY_HH__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "fastjet/PseudoJet.hh"
+
+//----------------------------------------------------------------------
+/// \class EventLibrary
+///
+/// All the events of a file, read once and kept in memory, so that
+/// they can be used again and again (e.g. as a pool of background
+/// events to draw from) without going back to the disk.
+///
+/// The particles are stored in columns as in the PU14Binary format
+/// (float px, py, pz, m and int32 pdgid, vertex: 24 bytes per
+/// particle), i.e. momenta are rounded to float precision.
+class EventLibrary {
+public:
+   EventLibrary() {}
+
+   /// reads the events of filename (any type EventSource can read);
+   /// max_events < 0 reads the whole file.  Returns false if no event
+   /// could be read.
+   bool load(const std::string & filename, const std::string & type, int max_events = -1);
+
+   size_t event_count() const {return _weight.size();}
+   size_t particle_count() const {return _pdgid.size();}
+
+   /// appends the particles of event i onto particles, with PU14 user
+   /// info, the same way EventSource::append_next_event does
+   void append_event(size_t i, std::vector<fastjet::PseudoJet> & particles,
+         double & event_weight) const;
+
+private:
+   std::vector<size_t> _start;   // first particle of each event, plus the end
+   std::vector<double> _weight;
+   std::vector<float> _px, _py, _pz, _m;
+   std::vector<int32_t> _pdgid, _vertex;
+};
+
+#endif // __EVENTLIBRARY_HH__
@@ -1,12 +1,14 @@
 #include "EventMixer.hh"
 #include "PU14.hh"
 #include "helpers.hh"
+#include "../include/randomStream.hh"
 #include <cstdlib>
+#include <sstream>
 
 using namespace std;
 
 //----------------------------------------------------------------------
-EventMixer::EventMixer(CmdLine * cmdline) : _cmdline(cmdline) {
+EventMixer::EventMixer(CmdLine * cmdline, int skip) : _cmdline(cmdline) {
 
   _hard_name   = _cmdline->value<string>("-hard");
   _pileup_name = _cmdline->value<string>("-pileup", "");
@@ -16,14 +18,20 @@ EventMixer::EventMixer(CmdLine * cmdline) : _cmdline(cmdline) {
   // setting the multiplicity of pileup events (background HI)
   //
   //  -npu <npu>  : fixed <npu> number of PU vertices - default to 1
+  //  -mu <mu>    : Poisson distributed, with mean <mu>
 
   // fixed (the default)
-  _npu = _cmdline->value("-npu", 1);
-  if(_npu > 1)
+  _npu = _npu_fixed = _cmdline->value("-npu", 1);
+  _hard_event_number = -1;
+  _pileup_after_event = -1;
+  _pileup_events_read = _pileup_particles_read = 0;
+  _mu = _cmdline->value("-mu", -1.0);
+  if(_npu > 1 || _mu > 1)
   {
-     cerr << "WARNING: number of background event requested = " << _npu << endl;
+     cerr << "WARNING: number of background event requested = " << mu() << endl;
      cerr << "   make sure you actually want that!" << endl;
   }
+  _pileup_seed = _cmdline->value("-pileupseed", 1);
 
   _massless = _cmdline->present("-massless");
 
@@ -36,43 +44,171 @@ EventMixer::EventMixer(CmdLine * cmdline) : _cmdline(cmdline) {
   _hard  .reset(new EventSource(_hard_name  , _hard_type));
   _hard->Recycle = false;
 
+  // part of the hard file only
+  string shard = _cmdline->value<string>("-shard", "");
+  if (shard != "") {
+    int k = -1, count = 0;
+    char separator = 0;
+    istringstream shard_stream(shard);
+    shard_stream >> k >> separator >> count;
+    if (separator != '/' || ! _hard->set_shard(k, count)) {
+      cerr << "ERROR: could not select shard " << shard << " of " << _hard_name << endl;
+      exit(-1);
+    }
+  }
+  skip += _cmdline->value("-skip", 0);
+  if (skip > 0) {
+    if (_hard_name != "-") _hard->use_index();
+    if (! _hard->skip_events(skip)) {
+      cerr << "WARNING: fewer than " << skip << " events to skip in " << _hard_name << endl;
+    }
+  }
+
   if (_pileup_name.empty()){
     cerr << "INFO: no background requested" << endl;
     _pileup.reset();
-    _npu=0;
+    _npu=_npu_fixed=0;
+    _mu=-1;
+  } else if (_cmdline->present("-pileuplibrary")) {
+    _pileup_library.reset(new EventLibrary());
+    if (! _pileup_library->load(_pileup_name, _pileup_type)) {
+      cerr << "ERROR: no pileup events in " << _pileup_name << endl;
+      exit(-1);
+    }
   } else {
     _pileup.reset(new EventSource(_pileup_name, _pileup_type));
     _pileup->Recycle = true;
   }
+
+  // read-ahead of mixed events in a separate thread
+  _prefetch = _cmdline->value("-prefetch", 0);
+  _reader_done = false;
+  _stop_reader = false;
+  if (_prefetch > 0) {
+    _reader = std::thread(&EventMixer::_prefetch_events, this);
+  }
+}
+
+//----------------------------------------------------------------------
+EventMixer::~EventMixer() {
+  if (_reader.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_queue_mutex);
+      _stop_reader = true;
+    }
+    _queue_drained.notify_all();
+    _reader.join();
+  }
 }
 
 //----------------------------------------------------------------------
 bool EventMixer::next_event() {
-  _particles.resize(0);
-  _hard_event_weight = 1;
-  _pu_event_weight = 1;
+  if (_prefetch <= 0)
+    return _mix_event(_particles, _hard_event_weight, _pu_event_weight, _npu,
+                      _hard_event_number);
+
+  MixedEvent event;
+  {
+    std::unique_lock<std::mutex> lock(_queue_mutex);
+    _queue_filled.wait(lock, [this]{return !_queue.empty() || _reader_done;});
+    if (_queue.empty()) {
+      _particles.resize(0);
+      return false;
+    }
+    event = std::move(_queue.front());
+    _queue.pop_front();
+  }
+  _queue_drained.notify_one();
+
+  _particles.swap(event.particles);
+  _hard_event_weight = event.hard_event_weight;
+  _pu_event_weight = event.pu_event_weight;
+  _npu = event.npu;
+  _hard_event_number = event.hard_event_number;
+  _hard_list = std::move(event.hard_list);
+  return true;
+}
+
+//----------------------------------------------------------------------
+void EventMixer::_prefetch_events() {
+  while (true) {
+    MixedEvent event;
+    bool ok = _mix_event(event.particles, event.hard_event_weight, event.pu_event_weight,
+                         event.npu, event.hard_event_number);
+    if (ok) event.hard_list = _hard->List;
+
+    std::unique_lock<std::mutex> lock(_queue_mutex);
+    _queue_drained.wait(lock, [this]{return _stop_reader || int(_queue.size()) < _prefetch;});
+    if (_stop_reader) return;
+    if (! ok) {
+      _reader_done = true;
+      lock.unlock();
+      _queue_filled.notify_all();
+      return;
+    }
+    _queue.push_back(std::move(event));
+    lock.unlock();
+    _queue_filled.notify_one();
+  }
+}
+
+//----------------------------------------------------------------------
+bool EventMixer::_mix_event(std::vector<fastjet::PseudoJet> & particles,
+                            double & hard_event_weight, double & pu_event_weight, int & npu,
+                            long long & hard_event_number) {
+  particles.resize(0);
+  hard_event_weight = 1;
+  pu_event_weight = 1;
   
   // first get the hard event
-  if (! _hard->append_next_event(_particles,_hard_event_weight,0)) return false;
+  if (! _hard->append_next_event(particles,hard_event_weight,0)) return false;
+  hard_event_number = (long long) _hard->next_event_number() - 1;
 
-  unsigned hard_size = _particles.size();
+  unsigned hard_size = particles.size();
+
+  // the random numbers of the pileup belong to the hard event, so that
+  // it gets the same pileup whatever -skip, -shard or -prefetch
+  randomStream rnd = randomService::stream(hard_event_number, "EventMixer", _pileup_seed);
 
   // add pileup if available
-  if (_pileup.get()){
-    for (int i = 1; i <= _npu; i++) {
-      if (! _pileup->append_next_event(_particles,_pu_event_weight,i)) return false;
+  npu = _npu_fixed;
+  if (_mu >= 0) npu = std::poisson_distribution<int>(_mu)(rnd);
+
+  // make room for all the pileup at once, instead of growing (and
+  // copying) the event again and again as pileup events are appended
+  particles.reserve(hard_size + _pileup_size_estimate(npu));
+  if (_pileup_library.get()){
+    std::uniform_int_distribution<size_t> pick(0, _pileup_library->event_count() - 1);
+    for (int i = 1; i <= npu; i++) {
+      _pileup_library->append_event(pick(rnd), particles, pu_event_weight);
     }
+  } else if (_pileup.get()){
+    // with a fixed npu, hard event h gets the pileup events from h*npu
+    // on, as when the file is read from the start: after a jump in the
+    // hard events (-skip, -shard, a resumed job) go there first
+    if (_mu < 0 && npu > 0 && hard_event_number != _pileup_after_event + 1
+        && _pileup->use_index() && _pileup->event_count() > 0) {
+      _pileup->seek_event((size_t(hard_event_number) * npu) % _pileup->event_count());
+    }
+    _pileup_after_event = hard_event_number;
+    for (int i = 1; i <= npu; i++) {
+      if (! _pileup->append_next_event(particles,pu_event_weight,i)) return false;
+    }
+    _pileup_events_read += npu;
+    _pileup_particles_read += particles.size() - hard_size;
+  } else {
+    npu = 0;
   }
 
   // make particles massless if requested
   if (_massless){
-    _particles = MasslessTransformer()(_particles);
+    particles = MasslessTransformer()(particles);
   }
 
   // apply CHS rescaling factor if requested
   if (chs_rescaling_factor() != 1.0) {
-    for (unsigned i = hard_size; i < _particles.size(); i++) {
-      if (_particles[i].user_info<PU14>().charge() != 0) _particles[i] *= _chs_rescaling_factor;
+    for (unsigned i = hard_size; i < particles.size(); i++) {
+      if (pu14_info(particles[i]).charge() != 0) particles[i] *= _chs_rescaling_factor;
     }
   }
 
@@ -80,13 +216,32 @@ bool EventMixer::next_event() {
 }
 
 
+//----------------------------------------------------------------------
+size_t EventMixer::_pileup_size_estimate(int npu) const {
+  if (npu <= 0) return 0;
+  double mean = 0;
+  if (_pileup_library.get() && _pileup_library->event_count() > 0) {
+    mean = double(_pileup_library->particle_count()) / _pileup_library->event_count();
+  } else if (_pileup_events_read > 0) {
+    mean = double(_pileup_particles_read) / _pileup_events_read;
+  }
+  // 10% on top of the mean, for events larger than average
+  return size_t(1.1 * npu * mean);
+}
+
 //----------------------------------------------------------------------
 string EventMixer::description() const {
   ostringstream ostr;
   ostr << "Event mixer using hard events from " << _hard_name;
+  if (_cmdline->present("-shard")) {
+    ostr << " (shard " << _cmdline->value<string>("-shard") << ")";
+  }
 
-  if (_npu > 0) {
-    ostr << " and " << _npu << " pileup events from " << _pileup_name;
+  if (mu() > 0) {
+    if (_mu >= 0) ostr << " and Poisson(" << _mu << ")";
+    else          ostr << " and " << _npu_fixed;
+    ostr << " pileup events from " << _pileup_name;
+    if (_pileup_library.get()) ostr << " (drawn at random from memory)";
   
     if (chs_rescaling_factor() != 1.0) {
     ostr << " with CHS (rescaling charged PU by a factor "
@@ -96,5 +251,8 @@ string EventMixer::description() const {
   if (_massless){
     ostr << " and massless particles";
   }
+  if (_prefetch > 0){
+    ostr << " (read " << _prefetch << " events ahead)";
+  }
   return ostr.str();
 }
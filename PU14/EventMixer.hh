@@ -1,8 +1,14 @@
 #ifndef __EVENTMIXER_HH__
 #define __EVENTMIXER_HH__
 
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
 #include "CmdLine.hh"
 #include "EventSource.hh"
+#include "EventLibrary.hh"
 
 //----------------------------------------------------------------------
 /// \class EventMixer
@@ -13,28 +19,66 @@
 ///
 ///   -hard HardFileName  -pileup PileupFileName  -npu NPU  [-chs]
 ///
-/// Currently the number of pileup events is fixed (not Poisson
-/// distributed).
+/// The pileup file is read sequentially (and started again when it
+/// ends), or with -pileuplibrary loaded once into memory and sampled
+/// at random.
+///
+/// The Poisson npu and the -pileuplibrary draws come from the random
+/// stream of the hard event (randomService, keyed by the number of the
+/// hard event in its file, the job seed and -pileupseed), so a hard
+/// event is mixed with the same pileup whatever -skip, -shard, -prefetch
+/// or the number of threads.  With a fixed npu the sequential pileup is
+/// too: hard event h gets the pileup events from h*npu on (modulo the
+/// size of the file), which needs the index of the pileup file when the
+/// hard events do not start at 0.  Poisson npu with sequential pileup
+/// depends on the hard events read before; use -pileuplibrary for that.
+/// Call randomService::setSeed before making the mixer.
 ///
 /// Additional options:
 ///  -chs       when present, the charged pileup particles come scaled
 ///             by a factor 10^{-60} (this factor can be modified from
 ///             within code).
 ///  -massless  when present, particles come massless
+///  -hardtype, -pileuptype  <type>
+///             format of the hard/pileup files: PU14 (default, text,
+///             optionally gzipped), PU14Stream (same format, read with
+///             the original istream parser), PU14Binary (see EventBinary.hh;
+///             files can be made with runConversionBinary), HepMC2
+///             or HepMC3
+///  -skip <N>  start at hard event N (counting from 0); the events are
+///             found through the side-car index of the hard file (see
+///             EventIndex), which is built on first use
+///  -shard <k>/<K>
+///             only use the k-th (counting from 0) of K equal slices of
+///             the hard file, e.g. for parallel jobs on one large file
+///  -pileuplibrary
+///             read the pileup file once into memory (see EventLibrary)
+///             and draw the pileup events of each hard event from it
+///             at random, with replacement
+///  -pileupseed <seed>
+///             extra key, next to -seed, of the pileup multiplicity and
+///             the -pileuplibrary draws (default 1)
+///  -prefetch <N>
+///             when N > 0, a background thread reads and mixes up to N
+///             events ahead of the one being analysed, so that the
+///             decompression and parsing overlap with the analysis
+///             (default 0: events are read when next_event() is called)
 ///
-///
-/// Pileup multiplicities can be specified using the following option
+/// Pileup multiplicities can be specified using the following options
 ///  -npu  <N>   fixed npu=N
+///  -mu   <mu>  Poisson distributed npu with mean mu
 class EventMixer {
 public:
-  EventMixer(CmdLine * cmdline);
-  ~EventMixer() {}
+  /// skip hard events are skipped on top of those of -skip, e.g. the
+  /// events a resumed job has already processed
+  EventMixer(CmdLine * cmdline, int skip = 0);
+  ~EventMixer();
 
   /// causes the next event to be read in and mixed (hard + multiple pileup).
   /// Returns true if it successfully produced the event, false otherwise.
   bool next_event(); 
 
-  const EventList &get_hard_list() {return _hard->List;}
+  const EventList &get_hard_list() {return (_prefetch > 0) ? _hard_list : _hard->List;}
 
   /// returns a reference to vector of particles in the last event
   /// that was read in
@@ -48,6 +92,15 @@ public:
   /// returns the number of pileup events generated in the last mixed event 
   int npu() const {return _npu;}
 
+  /// returns the number of the last hard event in its file (from 0,
+  /// whatever -skip or -shard), e.g. to key the random numbers of the
+  /// event
+  long long hard_event_number() const {return _hard_event_number;}
+
+  /// returns the mean number of pileup events (the fixed npu when it
+  /// is not Poisson distributed)
+  double mu() const {return (_mu >= 0) ? _mu : _npu_fixed;}
+
   /// Charged-hadron subtraction (CHS) can be "simulated" by scaling
   /// the charged particles from PU vertices by a factor
   /// _chs_rescaling_factor chosen << 1. This function returns the
@@ -65,17 +118,55 @@ public:
   std::string description() const;
 
 private:
+  /// one mixed event, as handed over by the read-ahead thread
+  struct MixedEvent {
+    std::vector<fastjet::PseudoJet> particles;
+    double hard_event_weight, pu_event_weight;
+    int npu;
+    long long hard_event_number;
+    EventList hard_list;
+  };
+
+  /// reads the hard and pileup events and mixes them into particles;
+  /// this is what next_event() does when there is no read-ahead
+  bool _mix_event(std::vector<fastjet::PseudoJet> & particles,
+                  double & hard_event_weight, double & pu_event_weight, int & npu,
+                  long long & hard_event_number);
+
+  /// body of the read-ahead thread
+  void _prefetch_events();
+
+  /// number of particles expected in npu pileup events, from the mean
+  /// event size of the library or of the pileup events read so far
+  size_t _pileup_size_estimate(int npu) const;
+
   CmdLine * _cmdline;
   std::string _hard_name, _pileup_name;
   std::string _hard_type, _pileup_type;
   fastjet::SharedPtr<EventSource> _hard, _pileup;
-  int _npu;
-  // GSLRandom _rng;
+  fastjet::SharedPtr<EventLibrary> _pileup_library;
+  int _npu;           // in the last event
+  long long _hard_event_number;
+  int _npu_fixed;
+  double _mu;         // < 0 for a fixed npu
+  int _pileup_seed;
+  long long _pileup_after_event;  // hard event the pileup file was last read for
+  long long _pileup_events_read, _pileup_particles_read;
   double _chs_rescaling_factor;
   bool _massless;
 
   std::vector<fastjet::PseudoJet> _particles;
   double _hard_event_weight, _pu_event_weight;
+  EventList _hard_list;
+
+  // read-ahead (-prefetch): the thread owns _hard and _pileup while it
+  // runs; the queue is the only thing shared with next_event()
+  int _prefetch;
+  std::thread _reader;
+  std::mutex _queue_mutex;
+  std::condition_variable _queue_filled, _queue_drained;
+  std::deque<MixedEvent> _queue;
+  bool _reader_done, _stop_reader;
 };
 
 #endif  // __EVENTMIXER_HH__
@@ -1,8 +1,11 @@
 #include "EventSource.hh"
+#include "EventBinary.hh"
 #include "FastIStringStream.hh"
+#include "FastTokenizer.hh"
 #include "PU14.hh"
 #include "zfstream.h"
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -29,26 +32,261 @@ void EventSource::open_stream(const std::string & filename) {
 }
 
 
+//----------------------------------------------------------------------
+void EventSource::open_text(const std::string & filename) {
+   if (! _text.open(filename)) {
+      cerr << "ERROR: could not access file " << filename << endl;
+      exit(-1);
+   }
+}
+
+
+//----------------------------------------------------------------------
+void EventSource::open_binary(const std::string & filename) {
+   if (! _mapped.open(filename)) {
+      cerr << "ERROR: could not access file " << filename << endl;
+      exit(-1);
+   }
+
+   PU14Binary::FileHeader header;
+   if (_mapped.size() < sizeof(header)) {
+      cerr << "ERROR: " << filename << " is too short to be a PU14Binary file" << endl;
+      exit(-1);
+   }
+   memcpy(&header, _mapped.data(), sizeof(header));
+   if (memcmp(header.magic, PU14Binary::Magic, sizeof(header.magic)) != 0
+         || header.version != PU14Binary::Version) {
+      cerr << "ERROR: " << filename << " is not a PU14Binary file (version "
+           << PU14Binary::Version << ")" << endl;
+      exit(-1);
+   }
+   _binary_offset = sizeof(header);
+}
+
+
 //----------------------------------------------------------------------
 bool EventSource::append_next_event(std::vector<fastjet::PseudoJet> & particles,
       double &event_weight, int vertex_number)
 {
+   if(_next_event >= _end_event)
+      return false;
+
+   bool Success = false;
    if(Type == FileType::Pu14)
-      return append_next_event_pu14(particles, event_weight, vertex_number);
+      Success = append_next_event_pu14(particles, event_weight, vertex_number);
+   else if(Type == FileType::Pu14Stream)
+      Success = append_next_event_pu14_stream(particles, event_weight, vertex_number);
+   else if(Type == FileType::Pu14Binary)
+      Success = append_next_event_binary(particles, event_weight, vertex_number);
    else if(Type == FileType::HepMC2)
-      return append_next_event_hepmc2(particles, event_weight, vertex_number);
+      Success = append_next_event_hepmc2(particles, event_weight, vertex_number);
    else if(Type == FileType::HepMC3)
-      return append_next_event_hepmc3(particles, event_weight, vertex_number);
+      Success = append_next_event_hepmc3(particles, event_weight, vertex_number);
+   else
+   {
+      std::cerr << "Error!  File type not found!" << std::endl;
+      return false;
+   }
+
+   // start again from the top, unless the file has no events at all
+   if(Success == false && Recycle == true && _next_event > 0 && rewind() == true)
+      return append_next_event(particles, event_weight, vertex_number);
+
+   if(Success == true)
+      _next_event = _next_event + 1;
+   return Success;
+}
+
+
+//----------------------------------------------------------------------
+bool EventSource::rewind()
+{
+   bool Success = false;
+   if(Type == FileType::Pu14Binary)
+   {
+      _binary_offset = sizeof(PU14Binary::FileHeader);
+      Success = true;
+   }
+   else if(Type == FileType::Pu14 || Type == FileType::HepMC2 || Type == FileType::HepMC3)
+   {
+      Success = _text.seek(0, std::vector<TextSource::RestartPoint>());
+      _hepmc_before_first_event = true;
+   }
+   else if(_stream_auto.get() != 0)
+   {
+      // a file opened through open_stream; stdin cannot go back
+      _stream->clear();
+      Success = bool(_stream->seekg(0));
+   }
+
+   if(Success == false)
+      cerr << "ERROR: cannot go back to the start of " << _filename << endl;
+   else
+      _next_event = 0;
+   return Success;
+}
+
+
+//----------------------------------------------------------------------
+bool EventSource::use_index()
+{
+   if(_indexed == true)
+      return true;
+   if(_filename == "-")
+   {
+      cerr << "ERROR: cannot index events read from stdin" << endl;
+      return false;
+   }
+   _indexed = _index.load_or_build(_filename, _type_name);
+   if(_indexed == false)
+      cerr << "ERROR: could not index " << _filename << endl;
+   return _indexed;
+}
 
-   std::cerr << "Error!  File type not found!" << std::endl;
 
-   return false;
+//----------------------------------------------------------------------
+bool EventSource::seek_event(size_t n)
+{
+   if(use_index() == false)
+      return false;
+   if(n >= _index.event_count())
+   {
+      cerr << "ERROR: cannot go to event " << n << " of " << _filename
+         << ", which has " << _index.event_count() << " events" << endl;
+      return false;
+   }
+
+   uint64_t Offset = _index.event(n).offset;
+   bool Success = false;
+   if(Type == FileType::Pu14Binary)
+   {
+      _binary_offset = Offset;
+      Success = true;
+   }
+   else if(Type == FileType::Pu14 || Type == FileType::HepMC2 || Type == FileType::HepMC3)
+   {
+      Success = _text.seek(Offset, _index.restart_points());
+      // the next line is the E line of event n
+      _hepmc_before_first_event = true;
+   }
+   else
+      cerr << "ERROR: events of type " << _type_name << " cannot be accessed by number" << endl;
+
+   if(Success == true)
+      _next_event = n;
+   return Success;
+}
+
+
+//----------------------------------------------------------------------
+bool EventSource::skip_events(size_t n)
+{
+   if(n == 0)
+      return true;
+   if(_indexed == true && _next_event + n < _index.event_count())
+      return seek_event(_next_event + n);
+
+   std::vector<fastjet::PseudoJet> Particles;
+   double Weight;
+   for(size_t i = 0; i < n; i++)
+   {
+      Particles.clear();
+      if(append_next_event(Particles, Weight) == false)
+         return false;
+   }
+   return true;
+}
+
+
+//----------------------------------------------------------------------
+bool EventSource::set_range(size_t first, size_t last)
+{
+   if(use_index() == false)
+      return false;
+
+   last = std::min(last, _index.event_count());
+   _end_event = last;
+   if(first >= last)
+   {
+      // nothing to read
+      _next_event = last;
+      return true;
+   }
+   return seek_event(first);
+}
+
+
+//----------------------------------------------------------------------
+bool EventSource::set_shard(int k, int count)
+{
+   if(count <= 0 || k < 0 || k >= count)
+   {
+      cerr << "ERROR: invalid shard " << k << " of " << count << endl;
+      return false;
+   }
+   if(use_index() == false)
+      return false;
+
+   size_t N = _index.event_count();
+   return set_range(N * k / count, N * (k + 1) / count);
 }
 
 
 //----------------------------------------------------------------------
 bool EventSource::append_next_event_pu14(std::vector<fastjet::PseudoJet> & particles,
       double &event_weight, int vertex_number)
+{
+   PseudoJet particle;
+   const char *begin, *end;
+   double px = 0, py = 0, pz = 0, m = 0, E;
+   int pdgid = 0, vertex = 0;
+
+   unsigned original_size = particles.size();
+   event_weight = 1;
+
+   // read in particles, straight from the mapped/decompressed buffer
+   while(_text.next_line(begin, end))
+   {
+      // ignore blank lines and comment lines
+      if (begin == end || begin[0] == '#') continue;
+
+      // if the line says "end" then assume we've found the end of the
+      // event
+      if (begin[0] == 'e' && end - begin >= 3 && strncmp(begin, "end", 3) == 0) break;
+
+      // if the line says "weight", we multiply current weight by the number that follows
+      if(begin[0] == 'w' && end - begin >= 6 && strncmp(begin, "weight", 6) == 0)
+      {
+         double temp = 1;
+         FastTokenizer readline(begin + 6, end);
+         readline >> temp;
+         if(temp > 0)
+            event_weight = event_weight * temp;
+         continue;
+      }
+
+      FastTokenizer readline(begin, end);
+      readline >> px >> py >> pz >> m >> pdgid >> vertex;
+      assert(!readline.error());
+
+      E = sqrt(px*px + py*py + pz*pz + m*m);
+      particle = PseudoJet(px,py,pz,E);
+
+      // now set the (compact) PU14 info
+      set_pu14_info(particle, pdgid, vertex);
+
+      // and add the particle to our final output
+      particles.push_back(particle);
+   }
+
+   // if there were no new particles, then we assume the event has an error
+   return (particles.size() != original_size);
+}
+
+
+//----------------------------------------------------------------------
+bool EventSource::append_next_event_pu14_stream(std::vector<fastjet::PseudoJet> & particles,
+      double &event_weight, int vertex_number)
 {
    PseudoJet particle;
    string line;
@@ -89,7 +327,8 @@ bool EventSource::append_next_event_pu14(std::vector<fastjet::PseudoJet> & parti
       E = sqrt(px*px + py*py + pz*pz + m*m);
       particle = PseudoJet(px,py,pz,E);
 
-      // now set the user info
+      // now set the user info (a heap-allocated PU14, as originally;
+      // pu14_info() reads both kinds)
       int barcode = particles.size();
       particle.set_user_info(new PU14(pdgid, barcode, vertex));
 
@@ -103,48 +342,96 @@ bool EventSource::append_next_event_pu14(std::vector<fastjet::PseudoJet> & parti
 
 
 
+//----------------------------------------------------------------------
+bool EventSource::append_next_event_binary(std::vector<fastjet::PseudoJet> & particles,
+      double &event_weight, int vertex_number)
+{
+   unsigned original_size = particles.size();
+   event_weight = 1;
+
+   const char * data = _mapped.data();
+   size_t size = _mapped.size();
+
+   PU14Binary::EventHeader header;
+   if(_binary_offset + sizeof(header) > size)
+      return false;
+   memcpy(&header, data + _binary_offset, sizeof(header));
+
+   if(_binary_offset + PU14Binary::event_size(header.n) > size)
+   {
+      cerr << "ERROR: truncated event in PU14Binary file" << endl;
+      _binary_offset = size;
+      return false;
+   }
+
+   // the columns are 4-byte aligned within the (page-aligned) mapping
+   unsigned n = header.n;
+   const float * px = reinterpret_cast<const float *>(data + _binary_offset + sizeof(header));
+   const float * py = px + n;
+   const float * pz = py + n;
+   const float * m  = pz + n;
+   const int32_t * pdgid  = reinterpret_cast<const int32_t *>(m + n);
+   const int32_t * vertex = pdgid + n;
+
+   if(header.weight > 0)
+      event_weight = header.weight;
+
+   for(unsigned i = 0; i < n; i++)
+   {
+      double x = px[i], y = py[i], z = pz[i], mass = m[i];
+      PseudoJet particle(x, y, z, sqrt(x*x + y*y + z*z + mass*mass));
+
+      set_pu14_info(particle, pdgid[i], vertex[i]);
+      particles.push_back(particle);
+   }
+
+   _binary_offset += PU14Binary::event_size(n);
+
+   // if there were no new particles, then we assume the event has an error
+   return (particles.size() != original_size);
+}
+
+
 //----------------------------------------------------------------------
 bool EventSource::append_next_event_hepmc3(std::vector<fastjet::PseudoJet> & particles,
       double &event_weight, int vertex_number)
 {
    EventHepMC3 &E = Event3;
 
-   static bool BeforeFirstEvent = true;
-   static string EventString = "";
+   const char *begin, *end;
    string line;
 
    E.Clean();
 
    bool EventDone = false;
 
-   while(getline(*_stream, line))
+   while(_text.next_line(begin, end))
    {
-      if(line.length() == 0 || line[0] == '#')
+      if(begin == end || begin[0] == '#')
          continue;
 
+      line.assign(begin, end);
       stringstream str(line);
       string Type;
       str >> Type;
 
       if(Type == "E")
       {
-         if(BeforeFirstEvent == true)
+         if(_hepmc_before_first_event == true)
          {
-            BeforeFirstEvent = false;
-            EventString = line;
+            _hepmc_before_first_event = false;
+            _hepmc_event_line = line;
             continue;
          }
 
          str.clear();
-         str.str(EventString);
+         str.str(_hepmc_event_line);
 
          string Dummy = "";
          str >> Dummy;   // should be "E"
 
          for(int i = 0; i < 3; i++)
             str >> E.E[i];
-         if(E.E[1] >= 100000)   E.E[1] = 100000;
-         if(E.E[2] >= 100000)   E.E[2] = 100000;
 
          str >> Dummy;
 
@@ -153,7 +440,7 @@ bool EventSource::append_next_event_hepmc3(std::vector<fastjet::PseudoJet> & par
                str >> E.ELocation[i];
          
          E.CopyParticles(particles, event_weight);
-         EventString = line;
+         _hepmc_event_line = line;
          EventDone = true;
          List.Initialize(E);
 
@@ -180,6 +467,7 @@ bool EventSource::append_next_event_hepmc3(std::vector<fastjet::PseudoJet> & par
       }
       if(Type == "V")
       {
+         E.GrowVertices();
          str >> E.V[0][E.VCount] >> E.V[1][E.VCount];
 
          // Do something here later if needed
@@ -195,6 +483,7 @@ bool EventSource::append_next_event_hepmc3(std::vector<fastjet::PseudoJet> & par
       }
       if(Type == "P")
       {
+         E.GrowParticles();
          for(int i = 0; i < 9; i++)
             str >> E.P[i][E.PCount];
          E.PCount = E.PCount + 1;
@@ -205,86 +494,108 @@ bool EventSource::append_next_event_hepmc3(std::vector<fastjet::PseudoJet> & par
 }
 
 
+//----------------------------------------------------------------------
+/// returns the record letter of a HepMC line ('E', 'V', 'P', ...), or 0
+/// for lines that do not start with a one-letter record (blank lines,
+/// comments, "HepMC::Version ...")
+static char hepmc_line_type(const char * begin, const char * end)
+{
+   if(begin == end)
+      return 0;
+   if(end - begin > 1 && begin[1] != ' ' && begin[1] != '\t')
+      return 0;
+   return begin[0];
+}
+
+
 //----------------------------------------------------------------------
 bool EventSource::append_next_event_hepmc2(std::vector<fastjet::PseudoJet> & particles,
       double &event_weight, int vertex_number)
 {
    EventHepMC2 &E = Event2;
 
-   static bool BeforeFirstEvent = true;
-   static string EventString = "";
-   string line;
+   const char *begin, *end;
    int PreviousV = 0;
+   bool TooLarge = false;
 
    E.Clean();
 
    bool EventDone = false;
 
-   while(getline(*_stream, line))
+   // lines are parsed in place; the only copy is the E line, which has to
+   // survive until the next E line closes the event
+   while(_text.next_line(begin, end))
    {
-      if(line.length() == 0 || line[0] == '#')
+      char Type = hepmc_line_type(begin, end);
+      if(Type == 0)
          continue;
 
-      stringstream str(line);
-      string Type;
-      str >> Type;
+      FastTokenizer str(begin + 1, end);
 
-      if(Type == "E")
+      if(Type == 'E')
       {
-         if(BeforeFirstEvent == true)
+         if(_hepmc_before_first_event == true)
          {
-            BeforeFirstEvent = false;
-            EventString = line;
+            _hepmc_before_first_event = false;
+            _hepmc_event_line.assign(begin, end);
             continue;
          }
 
-         str.clear();
-         str.str(EventString);
+         FastTokenizer header(_hepmc_event_line.data() + 1, _hepmc_event_line.data() + _hepmc_event_line.size());
 
-         string Dummy = "";
-         str >> Dummy;   // should be "E"
-         
          for(int i = 0; i < 10; i++)
-            str >> E.E[i];
+            header >> E.E[i];
 
-         str >> E.E[10];
+         header >> E.E[10];
          if(E.E[10] != 0)
             for(int i = 0; i < E.E[10]; i++)
-               str >> E.ERand;
-         str >> E.E[11];
+               header >> E.ERand;
+         header >> E.E[11];
          if(E.E[11] != 0)
          {
             E.EWeight = 1;
             double Weight = 1;
             for(int i = 0; i < E.E[11]; i++)
             {
-               str >> Weight;
+               header >> Weight;
                E.EWeight = E.EWeight * Weight;
             }
          }
          else
             E.EWeight = 1;
-         
+
          E.CopyParticles(particles, event_weight);
-         EventString = line;
+         _hepmc_event_line.assign(begin, end);
          EventDone = true;
          List.Initialize(E);
 
          break;
       }
-      if(Type == "N")   for(int i = 0; i < 2; i++)    str >> E.N[i];
-      if(Type == "U")   for(int i = 0; i < 2; i++)    str >> E.U[i];
-      if(Type == "C")   for(int i = 0; i < 2; i++)    str >> E.C[i];
-      if(Type == "H")   for(int i = 0; i < 13; i++)   str >> E.H[i];
-      if(Type == "F")   for(int i = 0; i < 9; i++)    str >> E.F[i];
-      if(Type == "V")
+      if(Type == 'N')   for(int i = 0; i < 2; i++)    str >> E.N[i];
+      if(Type == 'U')   for(int i = 0; i < 2; i++)    str >> E.U[i];
+      if(Type == 'C')   for(int i = 0; i < 2; i++)    str >> E.C[i];
+      if(Type == 'H')   for(int i = 0; i < 13; i++)   str >> E.H[i];
+      if(Type == 'F')   for(int i = 0; i < 9; i++)    str >> E.F[i];
+      if(Type == 'V' || Type == 'P')
+      {
+         bool Room = (Type == 'V') ? E.GrowVertices() : E.GrowParticles();
+         if(Room == false)
+         {
+            if(TooLarge == false)
+               cerr << "ERROR: HepMC2 event with more than " << int(EventHepMC2::MaxCount)
+                  << " particles or vertices, the rest of the event is ignored" << endl;
+            TooLarge = true;
+            continue;
+         }
+      }
+      if(Type == 'V')
       {
          for(int i = 0; i < 9; i++)
             str >> E.V[i][E.VCount];
          PreviousV = E.V[0][E.VCount];
          E.VCount = E.VCount + 1;
       }
-      if(Type == "P")
+      if(Type == 'P')
       {
          for(int i = 0; i < 12; i++)
             str >> E.P[i][E.PCount];
@@ -6,9 +6,13 @@
 #include <istream>
 #include <memory>
 #include <map>
+#include <algorithm>
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/SharedPtr.hh"
 #include "PU14.hh"
+#include "MappedFile.hh"
+#include "TextSource.hh"
+#include "EventIndex.hh"
 
 class EventHepMC3;
 class EventHepMC2;
@@ -21,8 +25,8 @@ public:
    int E[3];
    double ELocation[4];
    double W;
-   double *P[9];
-   double *V[6];
+   std::vector<double> P[9];   // one column per field, grown as needed
+   std::vector<double> V[6];
    double AHeavyIon[14];
    double AEventScale;
    double AProcessID;
@@ -36,18 +40,8 @@ public:
       EventCount = 0;
       PCount = 0;
       VCount = 0;
-      for(int i = 0; i < 9; i++)
-         P[i] = new double[100000];
-      for(int i = 0; i < 6; i++)
-         V[i] = new double[100000];
-   }
-   ~EventHepMC3()
-   {
-      for(int i = 0; i < 9; i++)
-         delete[] P[i];
-      for(int i = 0; i < 6; i++)
-         delete[] V[i];
    }
+   ~EventHepMC3() {}
    void Clean()
    {
       for(int i = 0; i < 3; i++)
@@ -55,12 +49,11 @@ public:
       for(int i = 0; i < 4; i++)
          ELocation[i] = 0;
       W = 0;
+      // rows beyond PCount/VCount are still zero from the previous reset
       for(int i = 0; i < 9; i++)
-         for(int j = 0; j < 100000; j++)
-            P[i][j] = 0;
+         std::fill(P[i].begin(), P[i].begin() + PCount, 0);
       for(int i = 0; i < 6; i++)
-         for(int j = 0; j < 100000; j++)
-            V[i][j] = 0;
+         std::fill(V[i].begin(), V[i].begin() + VCount, 0);
       for(int i = 0; i < 14; i++)
          AHeavyIon[i] = 0;
       AEventScale = 0;
@@ -69,11 +62,29 @@ public:
       PCount = 0;
       VCount = 0;
    }
+   /// make room for particle row PCount
+   void GrowParticles()
+   {
+      if(PCount < (int)P[0].size())
+         return;
+      size_t Size = std::max<size_t>(1024, 2 * P[0].size());
+      for(int i = 0; i < 9; i++)
+         P[i].resize(Size, 0);
+   }
+   /// make room for vertex row VCount
+   void GrowVertices()
+   {
+      if(VCount < (int)V[0].size())
+         return;
+      size_t Size = std::max<size_t>(1024, 2 * V[0].size());
+      for(int i = 0; i < 6; i++)
+         V[i].resize(Size, 0);
+   }
    void CopyParticles(std::vector<fastjet::PseudoJet> & particles, double &event_weight)
    {
       event_weight = W;
-      particles.clear();
-      for(int i = 0; i < E[2]; i++)
+      int Count = std::min(E[2], PCount);
+      for(int i = 0; i < Count; i++)
       {
          bool Tag = false;
 
@@ -92,7 +103,7 @@ public:
             continue;
 
          fastjet::PseudoJet particle = fastjet::PseudoJet(P[3][i], P[4][i], P[5][i], P[6][i]);
-         particle.set_user_info(new PU14(P[2][i], i, vertex));
+         set_pu14_info(particle, P[2][i], vertex);
          
          if(particle.perp() < 1e-5 && fabs(particle.pz()) > 2000)
             continue;
@@ -101,7 +112,7 @@ public:
          if(Tag == true)
          {
             fastjet::PseudoJet particle2 = fastjet::PseudoJet(P[3][i] * 1e-10, P[4][i] * 1e-10, P[5][i] * 1e-10, P[6][i] * 1e-10);
-            particle2.set_user_info(new PU14(P[2][i], i, 0));
+            set_pu14_info(particle2, P[2][i], 0);
             particles.push_back(particle2);
          }
       }
@@ -111,6 +122,10 @@ public:
 
 class EventHepMC2
 {
+public:
+   /// largest number of particles (or vertices) accepted in one event;
+   /// the rest of a bigger event is dropped with an error
+   static const int MaxCount = 1000000;
 public:
    double E[12];
    int ERand;
@@ -120,35 +135,62 @@ public:
    double C[2];
    double H[13];
    double F[9];
-   double V[9][10000];
+   std::vector<double> V[9];    // one column per field, grown as needed
    int VCount;
    int PCount;
-   double P[13][10000];   // index 12 is mother vertex
+   std::vector<double> P[13];   // index 12 is mother vertex
    double EventCount;
 public:
-   EventHepMC2() {}
+   EventHepMC2()
+   {
+      EventCount = 0;
+      PCount = 0;
+      VCount = 0;
+   }
    ~EventHepMC2() {}
    void Clean()
    {
       for(int i = 0; i < 12; i++)   E[i] = 0;
-      for(int i = 0; i < 2; i++)    N[i] = "";
-      for(int i = 0; i < 2; i++)    U[i] = "";
+      for(int i = 0; i < 2; i++)    N[i].clear();
+      for(int i = 0; i < 2; i++)    U[i].clear();
       for(int i = 0; i < 2; i++)    C[i] = 0;
       for(int i = 0; i < 13; i++)   H[i] = 0;
       for(int i = 0; i < 9; i++)    F[i] = 0;
-      VCount = 0;
+      // rows beyond PCount/VCount are still zero from the previous reset
       for(int i = 0; i < 9; i++)
-         for(int j = 0; j < 10000; j++)
-            V[i][j] = 0;
+         std::fill(V[i].begin(), V[i].begin() + VCount, 0);
+      VCount = 0;
+      for(int i = 0; i < 13; i++)
+         std::fill(P[i].begin(), P[i].begin() + PCount, 0);
       PCount = 0;
+   }
+   /// make room for particle row PCount; false if the event is too large
+   bool GrowParticles()
+   {
+      if(PCount < (int)P[0].size())
+         return true;
+      if(PCount >= MaxCount)
+         return false;
+      size_t Size = std::min<size_t>(MaxCount, std::max<size_t>(1024, 2 * P[0].size()));
       for(int i = 0; i < 13; i++)
-         for(int j = 0; j < 10000; j++)
-            P[i][j] = 0;
+         P[i].resize(Size, 0);
+      return true;
+   }
+   /// make room for vertex row VCount; false if the event is too large
+   bool GrowVertices()
+   {
+      if(VCount < (int)V[0].size())
+         return true;
+      if(VCount >= MaxCount)
+         return false;
+      size_t Size = std::min<size_t>(MaxCount, std::max<size_t>(1024, 2 * V[0].size()));
+      for(int i = 0; i < 9; i++)
+         V[i].resize(Size, 0);
+      return true;
    }
    void CopyParticles(std::vector<fastjet::PseudoJet> & particles, double &event_weight)
    {
       event_weight = EWeight;
-      particles.clear();
       for(int i = 0; i < PCount; i++)
       {
          bool Tag = false;
@@ -168,7 +210,7 @@ public:
             continue;
 
          fastjet::PseudoJet particle = fastjet::PseudoJet(P[2][i], P[3][i], P[4][i], P[5][i]);
-         particle.set_user_info(new PU14(P[1][i], i, vertex));
+         set_pu14_info(particle, P[1][i], vertex);
 
          if(particle.perp() < 1e-5 && fabs(particle.pz()) > 2000)
             continue;
@@ -177,7 +219,7 @@ public:
          if(Tag == true)
          {
             fastjet::PseudoJet particle2 = fastjet::PseudoJet(P[2][i] * 1e-10, P[3][i] * 1e-10, P[4][i] * 1e-10, P[5][i] * 1e-10);
-            particle2.set_user_info(new PU14(P[1][i], i, 0));
+            set_pu14_info(particle2, P[1][i], 0);
             particles.push_back(particle2);
          }
       }
@@ -437,20 +479,37 @@ public:
 //----------------------------------------------------------------------
 /// \class EventSource
 ///
-/// Class for reading events from a file (or stdin) in some simple format
+/// Class for reading events from a file (or stdin) in some simple format.
+/// All the reading state lives in the instance, so several sources can be
+/// read side by side (e.g. hard and pileup both in HepMC), and separate
+/// instances can be used from separate threads.  A single instance is not
+/// meant to be shared between threads.
 class EventSource
 {
 public:
-   enum FileType {Pu14, HepMC2, HepMC3, Unknown};
+   enum FileType {Pu14, Pu14Stream, Pu14Binary, HepMC2, HepMC3, Unknown};
 
+   /// when true, the source starts again from the first event once the
+   /// end of the file is reached (e.g. for pileup)
    bool Recycle;
 
    EventSource(const std::string & filename, const std::string &type)
    {
-      open_stream(filename);
+      _stream = 0;
+      _binary_offset = 0;
+      _hepmc_before_first_event = true;
+      _filename = filename;
+      _type_name = type;
+      _indexed = false;
+      _next_event = 0;
+      _end_event = size_t(-1);
 
       if(type == "PU14")
          Type = FileType::Pu14;
+      else if(type == "PU14Stream")
+         Type = FileType::Pu14Stream;
+      else if(type == "PU14Binary")
+         Type = FileType::Pu14Binary;
       else if(type == "HepMC2")
          Type = FileType::HepMC2;
       else if(type == "HepMC3")
@@ -458,28 +517,94 @@ public:
       else
          Type = FileType::Unknown;
 
+      if(Type == FileType::Pu14 || Type == FileType::HepMC2 || Type == FileType::HepMC3)
+         open_text(filename);
+      else if(Type == FileType::Pu14Binary)
+         open_binary(filename);
+      else
+         open_stream(filename);
+
       Recycle = false;
    }
 
    /// set up an event stream from the corresponding file (in the PU14 format) 
    void open_stream(const std::string & filename);
 
+   /// set up zero-copy line access to a text file (mapped, or
+   /// decompressed in large blocks for .gz files)
+   void open_text(const std::string & filename);
+
+   /// map a file in the PU14Binary format (see EventBinary.hh)
+   void open_binary(const std::string & filename);
+
    /// appends the particles from the next event that is read onto the 
    /// particles vector.
    bool append_next_event(std::vector<fastjet::PseudoJet> & particles,
          double &event_weight, int vertex_number = 0);
    bool append_next_event_pu14(std::vector<fastjet::PseudoJet> & particles,
          double &event_weight, int vertex_number = 0);
+   /// the original istream-based PU14 reader (file type "PU14Stream"),
+   /// kept as a reference for benchmarks
+   bool append_next_event_pu14_stream(std::vector<fastjet::PseudoJet> & particles,
+         double &event_weight, int vertex_number = 0);
+   bool append_next_event_binary(std::vector<fastjet::PseudoJet> & particles,
+         double &event_weight, int vertex_number = 0);
    bool append_next_event_hepmc2(std::vector<fastjet::PseudoJet> & particles,
          double &event_weight, int vertex_number = 0);
    bool append_next_event_hepmc3(std::vector<fastjet::PseudoJet> & particles,
          double &event_weight, int vertex_number = 0);
 
+   /// loads the side-car index of the file (see EventIndex), building
+   /// it first if needed.  Needed for event_count, seek_event,
+   /// set_range and set_shard.
+   bool use_index();
+   bool has_index() const {return _indexed;}
+
+   /// number of events in the file (0 without an index)
+   size_t event_count() const {return _indexed ? _index.event_count() : 0;}
+
+   /// number (counting from 0) of the event the next
+   /// append_next_event call returns
+   size_t next_event_number() const {return _next_event;}
+
+   /// positions the source at event n (counting from 0)
+   bool seek_event(size_t n);
+
+   /// goes back to the first event of the file (no index needed)
+   bool rewind();
+
+   /// skips n events: through the index if there is one, by reading
+   /// them otherwise
+   bool skip_events(size_t n);
+
+   /// restricts reading to the events [first, last) of the file
+   bool set_range(size_t first, size_t last);
+
+   /// restricts reading to shard k (counting from 0) of count: the
+   /// events [k N / count, (k + 1) N / count) of a file with N events
+   bool set_shard(int k, int count);
+
 private:
    std::istream * _stream;
    fastjet::SharedPtr<std::istream> _stream_auto;
    FileType Type;
 
+   TextSource _text;
+   MappedFile _mapped;
+   size_t _binary_offset;
+
+   // HepMC events only end at the next E line, so the E line read at the
+   // end of one call is the header of the event returned by the next one
+   bool _hepmc_before_first_event;
+   std::string _hepmc_event_line;
+
+   std::string _filename;
+   std::string _type_name;
+   EventIndex _index;
+   bool _indexed;
+   size_t _next_event;
+   size_t _end_event;   // append_next_event stops here (set_range)
+
    EventHepMC2 Event2;
    EventHepMC3 Event3;
 
@@ -0,0 +1,193 @@
+// -*- C++ -*-
+#ifndef __FASTTOKENIZER_HH__
+#define __FASTTOKENIZER_HH__
+
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+/// class to read whitespace-separated numbers and words from a range
+/// of characters [begin, end) that does not need to be null-terminated
+/// (e.g. one line of a memory-mapped file).  It follows the interface
+/// of FastIStringStream, but parses the numbers itself instead of going
+/// through strtod/strtol, and never copies the input.
+///
+/// Numbers whose digits fit in 2^53 and whose decimal exponent is
+/// within +-22 (which covers everything written by our generators) are
+/// converted exactly with a single multiplication or division; anything
+/// else is handed to strtod, so the result is always identical to what
+/// strtod would give.
+class FastTokenizer {
+public:
+  /// constructor
+  FastTokenizer(const char * begin, const char * end) :
+    _next(begin), _end(end), _error(false) {}
+
+  /// reads the next token into value. On failure the value is left
+  /// untouched and the error flag is set.
+  template<class T> FastTokenizer & operator>>(T & value) {
+    if (!_get(value)) _error = true;
+    return *this;
+  }
+
+  /// skips the next token
+  FastTokenizer & skip() {
+    _skip_space();
+    if (_next == _end) _error = true;
+    while (_next != _end && !_is_space(*_next)) ++_next;
+    return *this;
+  }
+
+  /// returns true if the next token is exactly the given word (the
+  /// token is consumed in that case)
+  bool next_is(const char * word) {
+    _skip_space();
+    size_t length = std::strlen(word);
+    if (size_t(_end - _next) < length) return false;
+    if (std::strncmp(_next, word, length) != 0) return false;
+    if (_next + length != _end && !_is_space(_next[length])) return false;
+    _next += length;
+    return true;
+  }
+
+  /// returns true if only whitespace is left
+  bool at_end() {_skip_space(); return _next == _end;}
+
+  /// returns true if an error was encountered during any of the
+  /// operator>> calls
+  bool error() const {return _error;}
+
+  /// true on absence of any errors
+  operator bool() const {return !_error;}
+
+private:
+  static bool _is_space(char c) {return c == ' ' || c == '\t' || c == '\r' || c == '\n';}
+  static bool _is_digit(char c) {return c >= '0' && c <= '9';}
+
+  void _skip_space() {while (_next != _end && _is_space(*_next)) ++_next;}
+
+  bool _get(double & x);
+  bool _get(float & x) {
+    double y;
+    if (!_get(y)) return false;
+    x = y;
+    return true;
+  }
+  bool _get(int & i);
+  bool _get(std::string & s) {
+    _skip_space();
+    if (_next == _end) return false;
+    const char * start = _next;
+    while (_next != _end && !_is_space(*_next)) ++_next;
+    s.assign(start, _next);
+    return true;
+  }
+
+  /// conversion of [start, stop) through strtod, for the rare cases
+  /// the fast path does not handle (nan, inf, long mantissas, ...)
+  bool _get_slow(const char * start, double & x);
+
+  const char * _next;
+  const char * _end;
+  bool _error;
+};
+
+
+//----------------------------------------------------------------------
+inline bool FastTokenizer::_get(double & x) {
+  // powers of ten that are exactly representable as doubles
+  static const double exact_powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  _skip_space();
+  const char * start = _next;
+  const char * p = _next;
+
+  bool negative = false;
+  if (p != _end && (*p == '-' || *p == '+')) {negative = (*p == '-'); ++p;}
+
+  uint64_t mantissa = 0;
+  int significant = 0;   // significant digits stored in mantissa
+  int exponent = 0;
+  bool has_digits = false;
+  bool overflow = false; // more digits than the fast path can take
+
+  for (; p != _end && _is_digit(*p); ++p) {
+    has_digits = true;
+    if (mantissa == 0 && *p == '0') continue;
+    if (significant < 19) {mantissa = mantissa * 10 + (*p - '0'); significant++;}
+    else {exponent++; overflow = true;}
+  }
+  if (p != _end && *p == '.') {
+    for (++p; p != _end && _is_digit(*p); ++p) {
+      has_digits = true;
+      if (mantissa == 0 && *p == '0') {exponent--; continue;}
+      if (significant < 19) {mantissa = mantissa * 10 + (*p - '0'); significant++; exponent--;}
+      else overflow = true;
+    }
+  }
+  if (!has_digits) return _get_slow(start, x);
+
+  if (p != _end && (*p == 'e' || *p == 'E')) {
+    const char * q = p + 1;
+    bool negative_exponent = false;
+    if (q != _end && (*q == '-' || *q == '+')) {negative_exponent = (*q == '-'); ++q;}
+    if (q != _end && _is_digit(*q)) {
+      int value = 0;
+      for (; q != _end && _is_digit(*q); ++q)
+        if (value < 100000) value = value * 10 + (*q - '0');
+      exponent += negative_exponent ? -value : value;
+      p = q;
+    }
+  }
+
+  // exact (correctly rounded) conversion if both the mantissa and the
+  // power of ten are exact doubles; otherwise let strtod do it
+  if (overflow || mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+    return _get_slow(start, x);
+
+  double value = double(mantissa);
+  if (exponent < 0) value /= exact_powers[-exponent];
+  else              value *= exact_powers[exponent];
+  x = negative ? -value : value;
+  _next = p;
+  return true;
+}
+
+//----------------------------------------------------------------------
+inline bool FastTokenizer::_get_slow(const char * start, double & x) {
+  const char * stop = start;
+  while (stop != _end && !_is_space(*stop)) ++stop;
+  if (stop == start) return false;
+
+  // strtod needs a null-terminated string
+  std::string token(start, stop);
+  char * token_end;
+  double value = std::strtod(token.c_str(), &token_end);
+  if (token_end == token.c_str()) return false;
+
+  x = value;
+  _next = start + (token_end - token.c_str());
+  return true;
+}
+
+//----------------------------------------------------------------------
+inline bool FastTokenizer::_get(int & i) {
+  _skip_space();
+  const char * p = _next;
+
+  bool negative = false;
+  if (p != _end && (*p == '-' || *p == '+')) {negative = (*p == '-'); ++p;}
+  if (p == _end || !_is_digit(*p)) return false;
+
+  long value = 0;
+  for (; p != _end && _is_digit(*p); ++p) value = value * 10 + (*p - '0');
+
+  i = negative ? -value : value;
+  _next = p;
+  return true;
+}
+
+#endif // __FASTTOKENIZER_HH__
@@ -62,6 +62,9 @@ bool isBaryon( const int & pid );
 bool isDiQuark( const int & pid );
 /// is this a valid hadron ID?
 bool isHadron( const int & pid );
+/// same as isHadron, but always decoded from the digits (isHadron looks
+/// up the common ids in a table built on first use)
+bool isHadronFromDigits( const int & pid );
 /// is this a valid lepton ID?
 bool isLepton( const int & pid );
 /// is this a valid ion ID?
@@ -102,6 +105,9 @@ int  lSpin( const int & pid );
 /// return 3 times the charge (3 x quark charge is an int)
 /// If this is a Q-ball, return 30 times the charge.
 int threeCharge( const int & pid );
+/// same as threeCharge, but always decoded from the digits (threeCharge
+/// looks up the common ids in a table built on first use)
+int threeChargeFromDigits( const int & pid );
 /// return the actual charge
 double charge( const int & pid );
 
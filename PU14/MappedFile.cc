@@ -0,0 +1,52 @@
+#include "MappedFile.hh"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------
+bool MappedFile::open(const std::string & filename) {
+   close();
+
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd < 0) return false;
+
+   struct stat info;
+   if (fstat(fd, &info) != 0) {
+      ::close(fd);
+      return false;
+   }
+
+   _size = info.st_size;
+   if (_size == 0) {
+      // nothing to map, but an empty file is still a valid file
+      ::close(fd);
+      _data = "";
+      return true;
+   }
+
+   void * address = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+   // the mapping stays valid after the descriptor is closed
+   ::close(fd);
+   if (address == MAP_FAILED) {
+      _size = 0;
+      return false;
+   }
+
+   // we read events front to back, so let the kernel read ahead
+   madvise(address, _size, MADV_SEQUENTIAL);
+
+   _data = static_cast<const char *>(address);
+   _mapped = true;
+   return true;
+}
+
+//----------------------------------------------------------------------
+void MappedFile::close() {
+   if (_mapped) munmap(const_cast<char *>(_data), _size);
+   _data = 0;
+   _size = 0;
+   _mapped = false;
+}
@@ -0,0 +1,40 @@
+#ifndef __MAPPEDFILE_HH__
+#define __MAPPEDFILE_HH__
+
+#include <string>
+#include <cstddef>
+
+//----------------------------------------------------------------------
+/// \class MappedFile
+///
+/// Read-only mapping of a whole file into memory (through mmap). The
+/// mapping is released when the object is closed or destroyed.
+class MappedFile {
+public:
+   MappedFile() : _data(0), _size(0), _mapped(false) {}
+   ~MappedFile() {close();}
+
+   /// maps the file; returns false if it could not be opened or mapped
+   bool open(const std::string & filename);
+
+   /// releases the mapping (if any)
+   void close();
+
+   /// returns true if a file is currently mapped
+   bool is_open() const {return _data != 0;}
+
+   /// start of the mapped region and its length in bytes
+   const char * data() const {return _data;}
+   size_t size() const {return _size;}
+
+private:
+   // a mapping cannot be shared between two owners
+   MappedFile(const MappedFile &);
+   MappedFile & operator=(const MappedFile &);
+
+   const char * _data;
+   size_t _size;
+   bool _mapped;   // false for empty files, which cannot be mmap'ed
+};
+
+#endif // __MAPPEDFILE_HH__
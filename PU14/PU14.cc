@@ -1,18 +1,78 @@
 #include "PU14.hh"
 #include <sstream>
 #include <memory>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <stdint.h>
 
 using namespace std;
 using namespace fastjet;
 
+//----------------------------------------------------------------------
+// the table behind set_pu14_info: entries are only ever appended, and a
+// particle can only carry an index once its entry has been written
+namespace {
+  // user_index values from here on refer to the table; smaller ones
+  // (-1 for ghosts and jets, positions set by other code) do not
+  const int PU14IndexBase = 1 << 30;
+  const int PU14MaxSpecies = 1 << 16;
+
+  const PU14 * species_table[PU14MaxSpecies];
+  int species_count = 0;
+  mutex species_mutex;
+  map<pair<int,int>, int> species_index;
+
+  /// position of (pdg_id, vertex) in the table, -1 if the table is full
+  int register_species(int pdg_id, int vertex) {
+    lock_guard<mutex> lock(species_mutex);
+    pair<int,int> key(pdg_id, vertex);
+    map<pair<int,int>, int>::const_iterator it = species_index.find(key);
+    if (it != species_index.end()) return it->second;
+    if (species_count == PU14MaxSpecies) return -1;
+    species_table[species_count] = new PU14(pdg_id, 0, vertex);
+    species_index[key] = species_count;
+    return species_count++;
+  }
+}
+
+//----------------------------------------------------------------------
+void set_pu14_info(fastjet::PseudoJet & p, int pdg_id, int vertex) {
+  // each thread keeps its own copy of the lookup, so the mutex is only
+  // taken the first time a thread sees a combination
+  static thread_local unordered_map<uint64_t, int> cache;
+  uint64_t key = (uint64_t(uint32_t(pdg_id)) << 32) | uint32_t(vertex);
+
+  int index;
+  unordered_map<uint64_t, int>::const_iterator it = cache.find(key);
+  if (it != cache.end()) {
+    index = it->second;
+  } else {
+    index = register_species(pdg_id, vertex);
+    cache[key] = index;
+  }
+
+  if (index < 0) p.set_user_info(new PU14(pdg_id, 0, vertex));
+  else           p.set_user_index(PU14IndexBase + index);
+}
+
+//----------------------------------------------------------------------
+const PU14 * pu14_info_ptr(const fastjet::PseudoJet & p) {
+  int index = p.user_index() - PU14IndexBase;
+  if (index >= 0 && index < PU14MaxSpecies) return species_table[index];
+  if (p.user_info_ptr() == 0) return 0;
+  return dynamic_cast<const PU14 *>(p.user_info_ptr());
+}
+
 std::ostream & operator<<(std::ostream & o, const fastjet::PseudoJet & p) {
   o << "pt = " << p.pt() << ", "
     << "rap = " << p.rap() << ", "
     << "phi = " << p.phi() << ", "
     << "m = " << p.m() ;
-  if (p.has_user_info<PU14>()) {
-    o << ", pdg_id = " << p.user_info<PU14>().pdg_id();
-    o << ", vertex = " << p.user_info<PU14>().vertex();
+  const PU14 * info = pu14_info_ptr(p);
+  if (info) {
+    o << ", pdg_id = " << info->pdg_id();
+    o << ", vertex = " << info->vertex();
   }
   return o;
 }
@@ -24,10 +84,9 @@ class SelectorWorkerIsCharged : public SelectorWorker {
 public:
 
   virtual bool pass(const PseudoJet & particle) const {
-    // we check that the user_info_ptr is non-zero so as to make
-    // sure that explicit ghosts don't cause the selector to fail
-    return (particle.user_info_ptr() != 0 && 
-	    particle.user_info<PU14>().three_charge() != 0);
+    // ghosts carry no PU14 information and are not charged
+    const PU14 * info = pu14_info_ptr(particle);
+    return (info != 0 && info->three_charge() != 0);
   }
   
   virtual string description() const {return "is_charged";}
@@ -47,10 +106,9 @@ public:
   SelectorWorkerVertexNumber(int vertex_number) : _vertex_number(vertex_number) {}
 
   virtual bool pass(const PseudoJet & particle) const {
-    // we check that the user_info_ptr is non-zero so as to make
-    // sure that explicit ghosts don't cause the selector to fail
-    return (particle.user_info_ptr() != 0 && 
-	    particle.user_info<PU14>().vertex_number() == _vertex_number);
+    // ghosts carry no PU14 information and fail the test
+    const PU14 * info = pu14_info_ptr(particle);
+    return (info != 0 && info->vertex_number() == _vertex_number);
   }
   
   virtual string description() const {
@@ -96,8 +154,8 @@ class SelectorWorkerPDGId : public SelectorWorker {
 public:
   SelectorWorkerPDGId(int i) : _id(i) {}
   virtual bool pass(const PseudoJet & particle) const {
-    return (particle.user_info_ptr() != 0 && 
-	    particle.user_info<PU14>().pdg_id() == _id);
+    const PU14 * info = pu14_info_ptr(particle);
+    return (info != 0 && info->pdg_id() == _id);
   }
   virtual string description() const {
     ostringstream ostr;
@@ -115,8 +173,8 @@ class SelectorWorkerAbsPDGId : public SelectorWorker {
 public:
   SelectorWorkerAbsPDGId(int i) : _id(i) {}
   virtual bool pass(const PseudoJet & particle) const {
-    return (particle.user_info_ptr() != 0 && 
-	    abs(particle.user_info<PU14>().pdg_id()) == _id);
+    const PU14 * info = pu14_info_ptr(particle);
+    return (info != 0 && abs(info->pdg_id()) == _id);
   }
   virtual string description() const {
     ostringstream ostr;
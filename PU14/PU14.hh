@@ -3,6 +3,7 @@
 
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/Selector.hh"
+#include "fastjet/Error.hh"
 #include "HepPID/ParticleIDMethods.hh"
 
 //----------------------------------------------------------------------
@@ -43,6 +44,37 @@ private:
 };
 
 
+//----------------------------------------------------------------------
+/// Compact PU14 information.  Instead of a heap-allocated PU14 user
+/// info per particle, the readers register each (pdg_id, vertex)
+/// combination once in a process-wide table and store its position in
+/// the particle's user_index.  Setting it costs no allocation and
+/// copying the particle no reference counting; the charge is computed
+/// once per combination.  (The barcode is not kept: it is the position
+/// of the particle in the event.)
+///
+/// pu14_info() gives access to the information either way, so it also
+/// works for particles with a PU14 user info made elsewhere.
+
+/// tags the particle with the given pdg id and vertex (this overwrites
+/// its user_index)
+void set_pu14_info(fastjet::PseudoJet & p, int pdg_id, int vertex = 0);
+
+/// the PU14 information of the particle, or 0 if it has none (e.g.
+/// ghosts)
+const PU14 * pu14_info_ptr(const fastjet::PseudoJet & p);
+
+/// true if the particle carries PU14 information
+inline bool has_pu14_info(const fastjet::PseudoJet & p) {return pu14_info_ptr(p) != 0;}
+
+/// the PU14 information of a particle that is known to carry it
+inline const PU14 & pu14_info(const fastjet::PseudoJet & p) {
+  const PU14 * info = pu14_info_ptr(p);
+  if (info == 0) throw fastjet::Error("particle without PU14 information");
+  return *info;
+}
+
+
 std::ostream & operator<<(std::ostream &o , const fastjet::PseudoJet & p);
 
 
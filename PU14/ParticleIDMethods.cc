@@ -208,8 +208,8 @@ bool isDiQuark( const int & pid )
     return false;
 }
 
-// is this a valid hadron ID?
-bool isHadron( const int & pid )
+// is this a valid hadron ID?  (decoded from the digits, see isHadron)
+bool isHadronFromDigits( const int & pid )
 {
     if( extraBits(pid) > 0 ) { return false; }
     if( isMeson(pid) )   { return true; }
@@ -469,8 +469,8 @@ int  lSpin( const int & pid )
     return 0;
 }
 
-// 3 times the charge
-int threeCharge( const int & pid )
+// 3 times the charge  (decoded from the digits, see threeCharge)
+int threeChargeFromDigits( const int & pid )
 {
     int charge=0;
     int ida, sid;
@@ -545,6 +545,63 @@ int threeCharge( const int & pid )
     return charge;
 }
 
+// ---  property table:
+//
+// threeCharge and isHadron are called for every particle of every event,
+// and decoding the digits each time is a good fraction of the cost of
+// reading an event.  The results for all |pid| < PropertyTableLimit (which
+// covers the quarks, leptons, bosons and the ordinary hadrons that the
+// generators produce) are therefore computed once, on first use, and
+// looked up afterwards; other ids are decoded as before.
+namespace {
+
+const int PropertyTableLimit = 10000;
+
+struct PropertyTable {
+    signed char threeCharge[2*PropertyTableLimit+1];
+    bool        isHadron[2*PropertyTableLimit+1];
+
+    PropertyTable()
+    {
+        for( int pid = -PropertyTableLimit; pid <= PropertyTableLimit; ++pid ) {
+            threeCharge[pid+PropertyTableLimit] = threeChargeFromDigits(pid);
+            isHadron[pid+PropertyTableLimit]    = isHadronFromDigits(pid);
+        }
+    }
+};
+
+// built on first use; the initialisation of a local static is thread safe
+const PropertyTable & propertyTable()
+{
+    static const PropertyTable table;
+    return table;
+}
+
+inline bool inPropertyTable( const int & pid )
+{
+    return pid > -PropertyTableLimit && pid < PropertyTableLimit;
+}
+
+} // unnamed namespace
+
+// is this a valid hadron ID?
+bool isHadron( const int & pid )
+{
+    if( inPropertyTable(pid) ) {
+        return propertyTable().isHadron[pid+PropertyTableLimit];
+    }
+    return isHadronFromDigits(pid);
+}
+
+// 3 times the charge
+int threeCharge( const int & pid )
+{
+    if( inPropertyTable(pid) ) {
+        return propertyTable().threeCharge[pid+PropertyTableLimit];
+    }
+    return threeChargeFromDigits(pid);
+}
+
 // the actual charge
 double charge( const int & pid )
 {
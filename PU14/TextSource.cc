@@ -0,0 +1,250 @@
+#include "TextSource.hh"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// size of the blocks that gzipped input is decompressed into
+static const size_t TextSourceBlockSize = 4 << 20;
+
+//----------------------------------------------------------------------
+bool TextSource::open(const std::string & filename) {
+  close();
+
+  bool compressed = (filename.length() > 3 &&
+                     filename.find(std::string(".gz")) + 3 == filename.length());
+
+  if (filename != "-" && !compressed) {
+    if (!_mapped.open(filename)) return false;
+    _pos = _mapped.data();
+    _end = _pos + _mapped.size();
+    _eof = true;   // everything is available from the start
+    return true;
+  }
+
+  _buffer.resize(TextSourceBlockSize);
+  _pos = _end = &_buffer[0];
+  _eof = false;
+
+  // gzread also passes uncompressed data from stdin straight through
+  if (filename == "-") {
+    _gz = gzdopen(fileno(stdin), "rb");
+    if (_gz == 0) return false;
+    gzbuffer(_gz, 1 << 17);
+    return true;
+  }
+
+  _file = fopen(filename.c_str(), "rb");
+  if (_file == 0) return false;
+  _input.resize(1 << 17);
+  return _restart(0);
+}
+
+//----------------------------------------------------------------------
+void TextSource::close() {
+  _mapped.close();
+  if (_gz != 0) gzclose(_gz);
+  _gz = 0;
+  if (_inflating) inflateEnd(&_stream);
+  _inflating = false;
+  if (_file != 0) fclose(_file);
+  _file = 0;
+  _buffer.clear();
+  _input.clear();
+  _points = 0;
+  _pos = _end = 0;
+  _eof = true;
+  _offset = 0;
+}
+
+//----------------------------------------------------------------------
+bool TextSource::next_line(const char * & begin, const char * & end) {
+  while (true) {
+    const char * newline = 0;
+    if (_pos != _end) newline = static_cast<const char *>(memchr(_pos, '\n', _end - _pos));
+
+    if (newline != 0) {
+      begin = _pos;
+      end   = newline;
+      _offset += newline + 1 - _pos;
+      _pos = newline + 1;
+      // be tolerant of files written with DOS line endings
+      if (end != begin && *(end - 1) == '\r') --end;
+      return true;
+    }
+
+    if (!_refill()) {
+      // last line without a trailing newline
+      if (_pos == _end) return false;
+      begin = _pos;
+      end   = _end;
+      _offset += _end - _pos;
+      _pos = _end;
+      return true;
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+bool TextSource::_refill() {
+  if (_eof) return false;
+
+  size_t remaining = _end - _pos;
+  if (remaining > 0 && _pos != &_buffer[0]) memmove(&_buffer[0], _pos, remaining);
+  // a single line longer than the whole buffer
+  if (remaining == _buffer.size()) _buffer.resize(2 * _buffer.size());
+
+  size_t count = 0;
+  if (_gz != 0) {
+    int n = gzread(_gz, &_buffer[remaining], _buffer.size() - remaining);
+    if (n < 0) {
+      int code;
+      cerr << "ERROR: while decompressing input: " << gzerror(_gz, &code) << endl;
+    }
+    if (n > 0) count = n;
+  } else {
+    count = _inflate(reinterpret_cast<unsigned char *>(&_buffer[remaining]),
+                     _buffer.size() - remaining);
+  }
+  if (count == 0) _eof = true;
+
+  _pos = &_buffer[0];
+  _end = _pos + remaining + count;
+  return count > 0;
+}
+
+//----------------------------------------------------------------------
+bool TextSource::_read_input() {
+  if (_stream.avail_in > 0) return true;
+  size_t n = fread(&_input[0], 1, _input.size(), _file);
+  if (n == 0) return false;
+  _file_pos += n;
+  _stream.next_in = &_input[0];
+  _stream.avail_in = n;
+  return true;
+}
+
+//----------------------------------------------------------------------
+size_t TextSource::_inflate(unsigned char * out, size_t size) {
+  if (!_inflating) return 0;
+
+  _stream.next_out = out;
+  _stream.avail_out = size;
+
+  while (_stream.avail_out > 0) {
+    if (!_read_input()) {
+      if (ferror(_file)) cerr << "ERROR: while reading compressed input" << endl;
+      break;
+    }
+
+    unsigned before = _stream.avail_out;
+    int ret = inflate(&_stream, _points ? Z_BLOCK : Z_NO_FLUSH);
+    _text_pos += before - _stream.avail_out;
+
+    if (ret == Z_STREAM_END) {
+      // after a restart the gzip trailer is left to us
+      if (_raw) {
+        for (int i = 0; i < 8 && _read_input(); i++) {
+          _stream.next_in++;
+          _stream.avail_in--;
+        }
+      }
+      // concatenated gzip files are read as one
+      if (!_read_input()) break;
+      inflateReset2(&_stream, 15 + 32);
+      _raw = false;
+      continue;
+    }
+    if (ret == Z_BUF_ERROR) continue;   // no progress possible, read more input
+    if (ret != Z_OK) {
+      // gzread ignores trailing garbage after a complete member as well
+      if (!(ret == Z_DATA_ERROR && _text_pos > 0 && _stream.total_out == 0))
+        cerr << "ERROR: while decompressing input: "
+             << (_stream.msg ? _stream.msg : "unknown zlib error") << endl;
+      inflateEnd(&_stream);
+      _inflating = false;
+      break;
+    }
+
+    // a deflate block boundary (not the end of the member) can serve as
+    // a restart point
+    if (_points && (_stream.data_type & 128) && !(_stream.data_type & 64)
+        && _text_pos >= _last_point + _span) {
+      _points->push_back(RestartPoint());
+      RestartPoint & point = _points->back();
+      point.text_offset = _text_pos;
+      point.file_offset = _file_pos - _stream.avail_in;
+      point.bits = _stream.data_type & 7;
+      uInt length = WindowSize;
+      inflateGetDictionary(&_stream, point.window, &length);
+      point.window_size = length;
+      _last_point = _text_pos;
+    }
+  }
+
+  return size - _stream.avail_out;
+}
+
+//----------------------------------------------------------------------
+bool TextSource::_restart(const RestartPoint * point) {
+  if (_inflating) inflateEnd(&_stream);
+  _inflating = false;
+
+  memset(&_stream, 0, sizeof(_stream));
+  uint64_t start = point ? point->file_offset - (point->bits ? 1 : 0) : 0;
+  if (fseeko(_file, start, SEEK_SET) != 0) return false;
+  _file_pos = start;
+
+  // 15 + 32: gzip or zlib header, detected automatically; -15: raw deflate
+  if (inflateInit2(&_stream, point ? -15 : 15 + 32) != Z_OK) return false;
+  _inflating = true;
+  _raw = (point != 0);
+  _text_pos = 0;
+
+  if (point) {
+    if (point->bits) {
+      int byte = fgetc(_file);
+      if (byte == EOF) return false;
+      _file_pos++;
+      inflatePrime(&_stream, point->bits, byte >> (8 - point->bits));
+    }
+    inflateSetDictionary(&_stream, point->window, point->window_size);
+    _text_pos = point->text_offset;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------
+bool TextSource::seek(uint64_t offset, const std::vector<RestartPoint> & points) {
+  if (_mapped.is_open()) {
+    if (offset > _mapped.size()) return false;
+    _pos = _mapped.data() + offset;
+    _offset = offset;
+    return true;
+  }
+  if (_file == 0) return false;
+
+  // the last restart point before offset (they are in increasing order)
+  const RestartPoint * point = 0;
+  for (size_t i = 0; i < points.size() && points[i].text_offset <= offset; i++)
+    point = &points[i];
+  if (!_restart(point)) {
+    cerr << "ERROR: could not reposition compressed input" << endl;
+    return false;
+  }
+
+  // decompress and drop everything up to offset
+  _pos = _end = &_buffer[0];
+  _eof = false;
+  uint64_t skip = offset - _text_pos;
+  while (skip > 0) {
+    if (!_refill()) return false;
+    uint64_t available = _end - _pos;
+    if (available > skip) available = skip;
+    _pos += available;
+    skip -= available;
+  }
+  _offset = offset;
+  return true;
+}
@@ -0,0 +1,115 @@
+#ifndef __TEXTSOURCE_HH__
+#define __TEXTSOURCE_HH__
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdint.h>
+#include "zlib.h"
+#include "MappedFile.hh"
+
+//----------------------------------------------------------------------
+/// \class TextSource
+///
+/// Line-by-line access to a text file without copying each line into
+/// a std::string.  Plain files are memory-mapped; gzipped files (and
+/// stdin, given as "-") are decompressed into large blocks.  The lines
+/// returned by next_line point into that memory and stay valid until
+/// the next call.
+///
+/// Plain and gzipped files can be repositioned with seek().  For gzipped
+/// files this needs restart points, i.e. snapshots of the decompressor
+/// taken every so often while the file is read once from the start (see
+/// record_restart_points); without them seek() decompresses from the
+/// beginning of the file.
+class TextSource {
+public:
+  /// size of the decompressor history stored with each restart point
+  static const int WindowSize = 32768;
+
+  /// state needed to restart decompression in the middle of a gzip file
+  struct RestartPoint {
+    uint64_t text_offset;   ///< position in the uncompressed text
+    uint64_t file_offset;   ///< first compressed byte still to be read
+    int32_t  bits;          ///< unused bits in the byte before file_offset
+    uint32_t window_size;   ///< bytes of history in window
+    unsigned char window[WindowSize];
+  };
+
+  TextSource() : _gz(0), _file(0), _inflating(false), _raw(false),
+                 _file_pos(0), _text_pos(0), _points(0), _span(0), _last_point(0),
+                 _pos(0), _end(0), _eof(true), _offset(0) {}
+  ~TextSource() {close();}
+
+  /// opens the file; returns false if it cannot be read
+  bool open(const std::string & filename);
+  void close();
+
+  /// sets [begin, end) to the next line (without the end-of-line
+  /// character); returns false at the end of the input
+  bool next_line(const char * & begin, const char * & end);
+
+  /// position of the next line in the (uncompressed) text; when reading
+  /// from the start this is the number of bytes handed out so far
+  uint64_t offset() const {return _offset;}
+
+  /// for gzipped files: while the file is read, append a restart point
+  /// to points every span bytes of text.  Must be called right after
+  /// open().
+  void record_restart_points(std::vector<RestartPoint> * points, uint64_t span) {
+    _points = points;
+    _span = span;
+    _last_point = 0;
+  }
+
+  /// moves to the given offset in the text, which should be the start of
+  /// a line; the restart points are only used for gzipped files.
+  /// Returns false if the input cannot be repositioned (stdin) or the
+  /// offset is past the end.
+  bool seek(uint64_t offset, const std::vector<RestartPoint> & points);
+
+private:
+  // the buffers cannot be shared between two owners
+  TextSource(const TextSource &);
+  TextSource & operator=(const TextSource &);
+
+  /// moves the unread part of the block to the front of the buffer and
+  /// appends the next decompressed block; returns false if nothing new
+  /// could be read
+  bool _refill();
+
+  /// decompresses up to size bytes of a gzipped file into out; returns
+  /// the number of bytes written (0 at the end of the file)
+  size_t _inflate(unsigned char * out, size_t size);
+
+  /// makes at least one more byte of compressed input available
+  bool _read_input();
+
+  /// restarts decompression at the beginning of the file or at a point
+  bool _restart(const RestartPoint * point);
+
+  MappedFile _mapped;
+  gzFile _gz;                  // stdin only
+  std::vector<char> _buffer;
+
+  // gzipped files are decompressed with zlib directly, which (unlike
+  // gzread) lets us take and restore snapshots of the decompressor
+  FILE * _file;
+  z_stream _stream;
+  bool _inflating;             // _stream is initialised
+  bool _raw;                   // restarted mid-member, no gzip header/trailer
+  std::vector<unsigned char> _input;
+  uint64_t _file_pos;          // compressed bytes read from _file
+  uint64_t _text_pos;          // uncompressed bytes produced by _stream
+
+  std::vector<RestartPoint> * _points;
+  uint64_t _span;
+  uint64_t _last_point;
+
+  const char * _pos;
+  const char * _end;
+  bool _eof;
+  uint64_t _offset;
+};
+
+#endif // __TEXTSOURCE_HH__
@@ -7,9 +7,10 @@ cd -
 WorkDir=$1
 Input=$2
 Output=$3
+Options=$4   # e.g. "-shard 2/10"
 
-echo $WorkDir/runJetTools -hard $Input -nev 2000
-$WorkDir/runJetTools -hard $Input -nev 2000
+echo $WorkDir/runJetTools -hard $Input -nev 2000 $Options
+$WorkDir/runJetTools -hard $Input -nev 2000 $Options
 
 mv JetToyHIResult.root $Output
 
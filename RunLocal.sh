@@ -0,0 +1,119 @@
+#!/bin/bash
+
+# Runs one of the run* programs on one hard-event file with several worker
+# processes on this machine, and merges their output into one file.
+#
+#    ./RunLocal.sh Program Input Output WorkerCount [options for the program]
+#    ./RunLocal.sh runJetTools Jewel_0_T_0.pu14 Jewel_0_T_0.root 16 -nev 100000
+#
+# Worker k reads the k-th of WorkerCount equal slices of Input (-shard k/N,
+# through the event index, which is built once before the workers start).
+# It runs in its own directory under Output.shards and is pinned to core k
+# when taskset is available.  Options such as -nev apply to each worker.
+# Options that name existing files (e.g. -pileup bkg.pu14) are made absolute,
+# and -output is reduced to its file name, so that every worker writes its
+# own file in its own directory.
+# When all workers succeeded their trees are merged with hadd in shard order,
+# so the entries of Output are in the order of the events in Input.  The
+# directory with the logs is removed unless a worker failed or KeepShards=1.
+
+if [[ $# -lt 4 ]]; then
+   echo "Usage: $0 Program Input Output WorkerCount [options for the program]"
+   exit 1
+fi
+
+WorkDir=$(cd $(dirname $0) && pwd)
+Program=$1
+Input=$(cd $(dirname $2) && pwd)/$(basename $2)
+Output=$3
+WorkerCount=$4
+shift 4
+
+# the workers run in their own directories
+Options=()
+Previous=
+for option in "$@"
+do
+   Value=$option
+   if [[ $Previous == -output ]]; then
+      Value=$(basename "$option")
+   elif [[ $option != -* && -e $option ]]; then
+      Value=$(cd "$(dirname "$option")" && pwd)/$(basename "$option")
+   fi
+   Options+=("$Value")
+   Previous=$option
+done
+
+ShardBase=$Output.shards
+CoreCount=$(nproc)
+
+if [[ ! -x $WorkDir/$Program ]]; then
+   echo "ERROR: $WorkDir/$Program not found, compile it first"
+   exit 1
+fi
+
+rm -rf $ShardBase
+mkdir -p $ShardBase
+
+# build the index once here, instead of in every worker at the same time
+HardType=PU14
+Previous=
+for option in "${Options[@]}"
+do
+   if [[ $Previous == -hardtype ]]; then
+      HardType=$option
+   fi
+   Previous=$option
+done
+$WorkDir/runBuildIndex -input $Input -type $HardType > $ShardBase/index.log 2>&1 \
+   || { echo "ERROR: could not index $Input, see $ShardBase/index.log"; exit 1; }
+
+Pinning=
+if command -v taskset > /dev/null; then
+   Pinning=taskset
+fi
+
+for shard in `seq 0 $((WorkerCount - 1))`
+do
+   ShardDir=$ShardBase/Shard$shard
+   mkdir -p $ShardDir
+
+   Command=($WorkDir/$Program -hard $Input -shard $shard/$WorkerCount "${Options[@]}")
+   if [[ $Pinning != "" ]]; then
+      Command=(taskset -c $((shard % CoreCount)) "${Command[@]}")
+   fi
+
+   echo "${Command[@]}" > $ShardDir/command
+   (cd $ShardDir && "${Command[@]}" > out.log 2> err.log) &
+   Workers[$shard]=$!
+done
+
+Failed=0
+for shard in `seq 0 $((WorkerCount - 1))`
+do
+   if ! wait ${Workers[$shard]}; then
+      echo "ERROR: worker $shard failed, see $ShardBase/Shard$shard/err.log"
+      Failed=1
+   fi
+done
+if [[ $Failed == 1 ]]; then
+   exit 1
+fi
+
+# each worker writes one ROOT file, whatever name its program uses
+ShardFiles=
+for shard in `seq 0 $((WorkerCount - 1))`
+do
+   ShardFile=`ls $ShardBase/Shard$shard/*.root 2> /dev/null`
+   if [[ `echo $ShardFile | wc -w` != 1 ]]; then
+      echo "ERROR: expected one ROOT file in $ShardBase/Shard$shard"
+      exit 1
+   fi
+   ShardFiles="$ShardFiles $ShardFile"
+done
+
+hadd -f $Output $ShardFiles > $ShardBase/hadd.log 2>&1 || { echo "ERROR: hadd failed, see $ShardBase/hadd.log"; exit 1; }
+
+if [[ $KeepShards != 1 ]]; then
+   rm -rf $ShardBase
+fi
@@ -1,6 +1,9 @@
 // Progress bar class
 // Author: Yi Chen
 
+#ifndef ProgressBar_h
+#define ProgressBar_h
+
 #include <iostream>
 #include <iomanip>
 #include <ostream>
@@ -234,8 +237,4 @@ void ProgressBar::Print(double progress)
       *Out << "\033[1GCurrent progress: " << progress - Min << std::flush;
 }
 
-
-
-
-
-
+#endif
@@ -6,6 +6,7 @@
 #include <string>
 #include <algorithm>
 #include <fstream>
+#include <memory>
 
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
@@ -14,6 +15,11 @@
 
 #include "../PU14/PU14.hh"
 
+#include "eventBackground.hh"
+#include "ghostSet.hh"
+#include "stageTimer.hh"
+#include "nearestParticleFinder.hh"
+
 using namespace std;
 using namespace fastjet;
 
@@ -39,6 +45,8 @@ class csSubtractor {
       std::vector<std::vector<fastjet::PseudoJet>> Hard;
       std::vector<std::vector<fastjet::PseudoJet>> Soft;
 
+      eventBackground *background_;
+
       contrib::ConstituentSubtractor subtractor_;
 
 
@@ -49,7 +57,8 @@ class csSubtractor {
          rParam_(rParam),
          ghostArea_(ghostArea),
          ghostRapMax_(ghostRapMax),
-         jetRapMax_(jetRapMax)
+         jetRapMax_(jetRapMax),
+         background_(0)
    {
       //init constituent subtractor
       subtractor_.set_distance_type(contrib::ConstituentSubtractor::deltaR);
@@ -64,8 +73,17 @@ class csSubtractor {
       void setGhostArea(double a) { ghostArea_ = a; }
 
       void setInputParticles(std::vector<fastjet::PseudoJet> v) { fjInputs_ = v; }
+      //anti-kt jets of the input particles clustered with explicit ghosts
+      //(active_area_explicit_ghosts), e.g. the inclusive jets of a
+      //ClusterSequenceArea the caller also uses for the unsubtracted jets;
+      //they must stay valid until doSubtraction() returns.  Without them
+      //doSubtraction() clusters the input particles itself.
       void setInputJets(std::vector<fastjet::PseudoJet> v)      { fjJetInputs_ = v; }
 
+      //use the background estimate of the event instead of making one
+      //(it must have been given the same input particles)
+      void setBackground(eventBackground *b) { background_ = b; }
+
       double getRho()  const { return rho_; }
       double getRhoM() const { return rhom_; }
       std::vector<std::vector<fastjet::PseudoJet>> getHard() const { return Hard; }
@@ -73,6 +91,8 @@ class csSubtractor {
 
       std::vector<fastjet::PseudoJet> doSubtraction() {
 
+         scopedTimer timer("csSubtractor");
+
          Hard.clear();
          Soft.clear();
 
@@ -81,36 +101,36 @@ class csSubtractor {
          //  return std::vector<fastjet::PseudoJet>();
          //}
 
-         fastjet::GhostedAreaSpec ghost_spec(ghostRapMax_, 1, ghostArea_);
-
-         std::vector<fastjet::PseudoJet> jets = fjJetInputs_;
-         //if(jets.size()==0) {
-
-         // do the clustering with ghosts and get the jets
+         // get the jets with ghosts: given, or clustered here
          //----------------------------------------------------------
-         fastjet::JetDefinition jet_def(antikt_algorithm, jetRParam_);
-         fastjet::AreaDefinition area_def = fastjet::AreaDefinition(fastjet::active_area_explicit_ghosts,ghost_spec);
-
-         fastjet::ClusterSequenceArea cs(fjInputs_, jet_def, area_def);
          fastjet::Selector jet_selector = SelectorAbsRapMax(jetRapMax_);
-         jets = fastjet::sorted_by_pt(jet_selector(cs.inclusive_jets()));
-         //}
+         std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts> cs;
+         std::vector<fastjet::PseudoJet> jets;
+         if(fjJetInputs_.size() > 0) {
+            jets = fastjet::sorted_by_pt(jet_selector(fjJetInputs_));
+         } else {
+            fastjet::JetDefinition jet_def(antikt_algorithm, jetRParam_);
+            ghostSet ghosts(ghostRapMax_, ghostArea_);
+
+            cs.reset(new fastjet::ClusterSequenceActiveAreaExplicitGhosts(fjInputs_, jet_def,
+                                                                           ghosts.getGhosts(), ghosts.getGhostArea()));
+            jets = fastjet::sorted_by_pt(jet_selector(cs->inclusive_jets()));
+         }
 
-         // create what we need for the background estimation
+         // background estimation, shared with the other subtractors
+         // of the event if setBackground was called
          //----------------------------------------------------------
-         fastjet::JetDefinition jet_def_bkgd(fastjet::kt_algorithm, 0.4);
-         fastjet::AreaDefinition area_def_bkgd(fastjet::active_area_explicit_ghosts,ghost_spec);
-         fastjet::Selector selector = fastjet::SelectorAbsRapMax(jetRapMax_-0.4) * (!fastjet::SelectorNHardest(2));
-         fastjet::JetMedianBackgroundEstimator bkgd_estimator(selector, jet_def_bkgd, area_def_bkgd);
-         bkgd_estimator.set_particles(fjInputs_);
-
-         rho_ = bkgd_estimator.rho();
-         rhom_ = bkgd_estimator.rho_m();
+         eventBackground ownBackground(ghostRapMax_, ghostArea_, jetRapMax_-0.4);
+         eventBackground *background = background_;
+         if(background == 0) {
+            ownBackground.setInputParticles(fjInputs_);
+            background = &ownBackground;
+         }
 
-         if(rho_ < 0)    rho_ = 0;
-         if(rhom_ < 0)   rhom_ = 0;
+         rho_ = background->getRho();
+         rhom_ = background->getRhoM();
 
-         subtractor_.set_background_estimator(&bkgd_estimator);
+         subtractor_.set_background_estimator(background->getEstimator());
          subtractor_.set_common_bge_for_rho_and_rhom(true);
 
          std::vector<fastjet::PseudoJet> csjets;
@@ -121,25 +141,18 @@ class csSubtractor {
             std::vector<fastjet::PseudoJet> particles, ghosts;
             fastjet::SelectorIsPureGhost().sift(subtracted_jet.constituents(), ghosts, particles);
 
+            //a subtracted constituent is hard if the closest original
+            //constituent is from the hard event
             std::vector<fastjet::PseudoJet> A, B;
             SelectorIsHard().sift(jet.constituents(), A, B);
+            nearestParticleFinder FinderA(A), FinderB(B);
 
             std::vector<fastjet::PseudoJet> hard, soft;
-            for(fastjet::PseudoJet p : subtracted_jet.constituents())
+            for(const fastjet::PseudoJet &p : subtracted_jet.constituents())
             {
                double BestA = -1, BestB = -1;
-               for(fastjet::PseudoJet x : A)
-               {
-                  double DR2 = p.squared_distance(x);
-                  if(BestA < 0 || BestA > DR2)
-                     BestA = DR2;
-               }
-               for(fastjet::PseudoJet x : B)
-               {
-                  double DR2 = p.squared_distance(x);
-                  if(BestB < 0 || BestB > DR2)
-                     BestB = DR2;
-               }
+               FinderA.nearest(p, &BestA);
+               FinderB.nearest(p, &BestB);
                if(BestA < BestB)
                   hard.push_back(p);
                else
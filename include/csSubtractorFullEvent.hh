@@ -12,6 +12,9 @@
 
 #include "fastjet/contrib/ConstituentSubtractor.hh"
 
+#include "eventBackground.hh"
+#include "stageTimer.hh"
+
 using namespace std;
 using namespace fastjet;
 
@@ -32,6 +35,8 @@ private :
   double rhom_;
   std::vector<fastjet::PseudoJet> fjInputs_;
 
+  eventBackground *background_;
+
   contrib::ConstituentSubtractor subtractor_;
 
   
@@ -42,7 +47,8 @@ public :
     ghostArea_(ghostArea),
     ghostRapMax_(ghostRapMax),
     rho_(-1),
-    rhom_(-1)
+    rhom_(-1),
+    background_(0)
   {
     //init constituent subtractor
     subtractor_.set_distance_type(contrib::ConstituentSubtractor::deltaR);
@@ -61,25 +67,32 @@ public :
 
   void setInputParticles(std::vector<fastjet::PseudoJet> v) { fjInputs_ = v; }
 
+  //use the background estimate of the event instead of making one
+  //(it must have been given the same input particles)
+  void setBackground(eventBackground *b) { background_ = b; }
+
   double getRho()  const { return rho_; }
   double getRhoM() const { return rhom_; }
   
   std::vector<fastjet::PseudoJet> doSubtraction() {
 
+    scopedTimer timer("csSubtractorFullEvent");
+
+    eventBackground ownBackground(ghostRapMax_, ghostArea_, ghostRapMax_-0.4);
     if(rho_<0.) {    
-      // create what we need for the background estimation
+      // background estimation, shared with the other subtractors of the
+      // event if setBackground was called
       //----------------------------------------------------------
-      fastjet::GhostedAreaSpec ghost_spec(ghostRapMax_, 1, ghostArea_);
-      fastjet::JetDefinition jet_def_bkgd(fastjet::kt_algorithm, 0.4);
-      fastjet::AreaDefinition area_def_bkgd(fastjet::active_area_explicit_ghosts,ghost_spec);
-      fastjet::Selector selector = fastjet::SelectorAbsRapMax(ghostRapMax_-0.4) * (!fastjet::SelectorNHardest(2));
-      fastjet::JetMedianBackgroundEstimator bkgd_estimator(selector, jet_def_bkgd, area_def_bkgd);
-      bkgd_estimator.set_particles(fjInputs_);
+      eventBackground *background = background_;
+      if(background == 0) {
+        ownBackground.setInputParticles(fjInputs_);
+        background = &ownBackground;
+      }
       
-      rho_ = bkgd_estimator.rho();
-      rhom_ = bkgd_estimator.rho_m();
+      rho_ = background->getRho();
+      rhom_ = background->getRhoM();
       
-      subtractor_.set_background_estimator(&bkgd_estimator);
+      subtractor_.set_background_estimator(background->getEstimator());
       subtractor_.set_common_bge_for_rho_and_rhom(true);
     } else {
       //if rho and rhom provided, use externally supplied densities
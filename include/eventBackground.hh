@@ -0,0 +1,131 @@
+#ifndef eventBackground_h
+#define eventBackground_h
+
+#include <iostream>
+#include <vector>
+#include <memory>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequenceArea.hh"
+#include "fastjet/tools/JetMedianBackgroundEstimator.hh"
+
+#include "ghostSet.hh"
+#include "stageTimer.hh"
+
+//---------------------------------------------------------------
+// Description
+// This class estimates the background densities of one event (rho,
+// rho_m and their fluctuations sigma, sigma_m) from the median of the
+// kt R=0.4 jets with explicit ghosts, excluding the two hardest jets.
+// The kt clustering is done on first use and kept, so all subtractors
+// given the same eventBackground (setBackground) share it instead of
+// clustering the event again for each subtraction variant.
+//
+// Make one per event; setInputParticles() starts a new event.  The
+// settings of the subtractors are ignored for the estimate: ghosts
+// up to |y| = ghostRapMax with area ghostArea, jets within |y| < rapMax.
+// With setGhosts() the clustering uses the given ghosts of the event
+// instead of generating its own (a ghostSet, so they do not depend on
+// the thread either).
+//---------------------------------------------------------------
+
+class eventBackground {
+
+private :
+  double ghostRapMax_;
+  double ghostArea_;
+  double rapMax_;
+  bool   done_;
+  double rho_;
+  double rhom_;
+  double sigma_;
+  double sigmam_;
+  std::vector<fastjet::PseudoJet> fjInputs_;
+  std::vector<fastjet::PseudoJet> jets_;
+  const ghostSet *ghosts_;
+  std::unique_ptr<ghostSet> ownGhosts_;
+
+  std::unique_ptr<fastjet::ClusterSequenceAreaBase> cs_;
+  std::unique_ptr<fastjet::JetMedianBackgroundEstimator> estimator_;
+
+  void estimate();
+
+public :
+  eventBackground(double ghostRapMax = 3.0, double ghostArea = 0.005, double rapMax = 2.6) :
+    ghostRapMax_(ghostRapMax),
+    ghostArea_(ghostArea),
+    rapMax_(rapMax),
+    done_(false),
+    rho_(0),
+    rhom_(0),
+    sigma_(0),
+    sigmam_(0),
+    ghosts_(0)
+  {
+  }
+
+  void setInputParticles(const std::vector<fastjet::PseudoJet> &v) {
+    fjInputs_ = v;
+    done_ = false;
+  }
+
+  //cluster with these ghosts (they must reach beyond rapMax by at
+  //least twice the kt R); they must outlive this object
+  void setGhosts(const ghostSet *g) {
+    ghosts_ = g;
+    done_ = false;
+  }
+
+  //the densities (rho and rho_m are at least 0)
+  double getRho()    { estimate(); return rho_; }
+  double getRhoM()   { estimate(); return rhom_; }
+  double getSigma()  { estimate(); return sigma_; }
+  double getSigmaM() { estimate(); return sigmam_; }
+
+  //the kt jets the median is taken over, sorted by pt
+  const std::vector<fastjet::PseudoJet> &getJets() { estimate(); return jets_; }
+
+  //the estimator itself, e.g. for contrib::ConstituentSubtractor
+  fastjet::JetMedianBackgroundEstimator *getEstimator() { estimate(); return estimator_.get(); }
+};
+
+void eventBackground::estimate()
+{
+  if(done_)
+    return;
+
+  scopedTimer timer("eventBackground");
+
+  //the estimator takes an area definition, but it is given the jets
+  fastjet::GhostedAreaSpec ghost_spec(ghostRapMax_, 1, ghostArea_);
+  fastjet::JetDefinition jet_def_bkgd(fastjet::kt_algorithm, 0.4);
+  fastjet::AreaDefinition area_def_bkgd(fastjet::active_area_explicit_ghosts,ghost_spec);
+  fastjet::Selector selector = fastjet::SelectorAbsRapMax(rapMax_) * (!fastjet::SelectorNHardest(2));
+
+  //the estimator refers to the jets of cs_, so it goes first
+  estimator_.reset();
+  const ghostSet *ghosts = ghosts_;
+  if(ghosts == 0) {
+    ownGhosts_.reset(new ghostSet(ghostRapMax_, ghostArea_));
+    ghosts = ownGhosts_.get();
+  }
+  cs_.reset(new fastjet::ClusterSequenceActiveAreaExplicitGhosts(fjInputs_, jet_def_bkgd,
+                                                                  ghosts->getGhosts(), ghosts->getGhostArea()));
+  std::vector<fastjet::PseudoJet> allJets = cs_->inclusive_jets();
+  jets_ = fastjet::sorted_by_pt(selector(allJets));
+
+  estimator_.reset(new fastjet::JetMedianBackgroundEstimator(selector, jet_def_bkgd, area_def_bkgd));
+  estimator_->set_jets(allJets);
+
+  rho_ = estimator_->rho();
+  rhom_ = estimator_->rho_m();
+  sigma_ = estimator_->sigma();
+  sigmam_ = estimator_->sigma_m();
+
+  if(rho_ < 0)    rho_ = 0;
+  if(rhom_ < 0)   rhom_ = 0;
+
+  done_ = true;
+}
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef eventLoop_h
+#define eventLoop_h
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "fastjet/PseudoJet.hh"
+
+#include "PU14/EventMixer.hh"
+
+#include "ProgressBar.h"
+#include "treeWriter.hh"
+#include "stageTimer.hh"
+#include "randomStream.hh"
+
+//---------------------------------------------------------------
+// Description
+// This class runs the event loop of the run programs: it reads nEvent
+// mixed events and calls the analysis for each of them, on nThreads
+// worker threads (option -nthreads)
+//
+// The analysis is called as analysis(event, writer) and fills the
+// output of one event into writer, without calling fillTree().  With
+// one thread writer is the output treeWriter itself.  With more, each
+// worker fills its own buffer and the buffers are moved into the output
+// tree in event order.  The events are read and the tree is written on
+// the calling thread; at most 2 x nThreads events are in flight.
+//
+// If the output treeWriter has a file (openFile), setCheckpoint(n) saves
+// the tree to it every n events (option -checkpoint).  When openFile()
+// resumed an earlier job the loop continues after the events already in
+// the tree; the EventMixer must then skip those hard events as well
+// (EventMixer(&cmdline, trw.getResumeEvents())).
+//
+// Before the analysis of an event the loop points randomService to the
+// number of its hard event in the file, so that the random numbers drawn
+// from randomService (and the ghosts of ghostSet and ghostSet::seeded) do
+// not depend on -nthreads, -shard, -skip or -resume.  See EventMixer for
+// which pileup options give the same pileup after -shard, -skip or
+// -resume.
+//
+// An exception thrown by the analysis on a worker thread stops the loop:
+// the events before it are written, the workers are joined and the
+// exception is rethrown by run() on the calling thread.
+//
+// If stageTimer is enabled the loop times reading (and mixing) the
+// events, the analysis and filling the tree, and prints the stageTimer
+// summary at the end.
+//
+// With more than one thread the analysis must not modify anything it
+// shares with other events, and fastjet must be built with
+// --enable-thread-safety (or --enable-limited-thread-safety)
+//---------------------------------------------------------------
+
+//the mixed event handed to the analysis
+struct eventData {
+  int iev;                                   //1 for the first event
+  long long hardEvent;                       //number of the hard event in its file
+  std::vector<fastjet::PseudoJet> particles;
+  double hardWeight;
+  double puWeight;
+  int npu;
+  EventList hardList;                        //only if keepHardList()
+};
+
+class eventLoop {
+
+private :
+  EventMixer *mixer_;
+  int nEvent_;
+  int nThreads_;
+  bool keepHardList_;
+  int checkpointEvery_;
+
+  struct slot {
+    eventData event;
+    treeWriter buffer;
+    bool done;
+    std::exception_ptr error;               //thrown by the analysis
+    slot() : buffer("buffer", false), done(false) {}
+  };
+
+public :
+  eventLoop(EventMixer &mixer, int nEvent, int nThreads = 1) :
+    mixer_(&mixer),
+    nEvent_(nEvent),
+    nThreads_(nThreads < 1 ? 1 : nThreads),
+    keepHardList_(false),
+    checkpointEvery_(0)
+  {
+  }
+
+  //also copy mixer.get_hard_list() into eventData::hardList
+  void keepHardList(bool keep = true) { keepHardList_ = keep; }
+
+  int getNThreads() const { return nThreads_; }
+
+  //save the output tree to its file every n events (0: never)
+  void setCheckpoint(int n) { checkpointEvery_ = n; }
+
+  //runs the loop and returns the number of events in the output (with
+  //those of a resumed job)
+  template <class Analysis>
+  int run(treeWriter &trw, Analysis analysis);
+
+private :
+  bool readEvent(eventData &event, int iev);
+  void eventDone(treeWriter &trw, int nDone);
+};
+
+void eventLoop::eventDone(treeWriter &trw, int nDone)
+{
+  if(checkpointEvery_ > 0 && nDone % checkpointEvery_ == 0) {
+    scopedTimer timer("checkpoint");
+    trw.checkpoint();
+  }
+}
+
+bool eventLoop::readEvent(eventData &event, int iev)
+{
+  scopedTimer timer("eventRead");
+  if(iev > nEvent_ || !mixer_->next_event())
+    return false;
+
+  event.iev = iev;
+  event.hardEvent = mixer_->hard_event_number();
+  event.particles = mixer_->particles();
+  event.hardWeight = mixer_->hard_weight();
+  event.puWeight = mixer_->pu_weight();
+  event.npu = mixer_->npu();
+  if(keepHardList_)
+    event.hardList = mixer_->get_hard_list();
+  return true;
+}
+
+template <class Analysis>
+int eventLoop::run(treeWriter &trw, Analysis analysis)
+{
+  ProgressBar Bar(std::cout, nEvent_);
+  Bar.SetStyle(-1);
+  unsigned int entryDiv = (nEvent_ > 200) ? nEvent_ / 200 : 1;
+
+  //events already written by the job this one resumes
+  int nDone = trw.getResumeEvents();
+
+  if(nThreads_ == 1) {
+    eventData event;
+    while(readEvent(event, nDone + 1)) {
+      nDone++;
+      Bar.Update(nDone);
+      Bar.PrintWithMod(entryDiv);
+
+      stageTimer::beginEvent();
+      randomService::beginEvent(event.hardEvent);
+      {
+        scopedTimer timer("analysis");
+        analysis(event, trw);
+      }
+      stageTimer::writeEvent(trw);
+
+      {
+        scopedTimer timer("fillTree");
+        trw.fillTree();
+      }
+      eventDone(trw, nDone);
+    }
+  } else {
+    //event iev lives in slots[(iev - 1) % nSlots] until it is written out
+    int nSlots = 2 * nThreads_;
+    std::vector<slot> slots(nSlots);
+    std::deque<int> todo;
+    bool finished = false;
+    std::mutex mutex;
+    std::condition_variable todoFilled, slotDone;
+    std::exception_ptr error;
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < nThreads_; i++) {
+      workers.push_back(std::thread([&]() {
+        while(true) {
+          std::unique_lock<std::mutex> lock(mutex);
+          todoFilled.wait(lock, [&]() { return !todo.empty() || finished; });
+          if(todo.empty())
+            break;
+          slot &s = slots[todo.front()];
+          todo.pop_front();
+          lock.unlock();
+
+          try {
+            stageTimer::beginEvent();
+            randomService::beginEvent(s.event.hardEvent);
+            {
+              scopedTimer timer("analysis");
+              analysis(s.event, s.buffer);
+            }
+            stageTimer::writeEvent(s.buffer);
+          } catch(...) {
+            s.error = std::current_exception();
+          }
+
+          lock.lock();
+          s.done = true;
+          slotDone.notify_all();
+        }
+      }));
+    }
+
+    int nRead = nDone;
+    bool more = true;
+    while(true) {
+      //keep the workers busy
+      while(more && nRead - nDone < nSlots) {
+        slot &s = slots[nRead % nSlots];
+        if(!readEvent(s.event, nRead + 1)) {
+          more = false;
+          break;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        s.done = false;
+        s.error = nullptr;
+        todo.push_back(nRead % nSlots);
+        nRead++;
+        todoFilled.notify_one();
+      }
+      if(nDone == nRead)
+        break;
+
+      //write out the next event in order
+      slot &s = slots[nDone % nSlots];
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        slotDone.wait(lock, [&]() { return s.done; });
+      }
+      if(s.error) {
+        error = s.error;
+        break;
+      }
+      {
+        scopedTimer timer("fillTree");
+        trw.takeEvent(s.buffer);
+        trw.fillTree();
+      }
+
+      nDone++;
+      eventDone(trw, nDone);
+      Bar.Update(nDone);
+      Bar.PrintWithMod(entryDiv);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+      todo.clear();
+    }
+    todoFilled.notify_all();
+    for(std::thread &worker : workers)
+      worker.join();
+    if(error)
+      std::rethrow_exception(error);
+  }
+
+  Bar.Update(nEvent_);
+  Bar.Print();
+  Bar.PrintLine();
+
+  stageTimer::printSummary();
+
+  return nDone;
+}
+
+#endif
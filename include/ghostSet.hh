@@ -0,0 +1,92 @@
+#ifndef ghostSet_h
+#define ghostSet_h
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequenceArea.hh"
+#include "fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh"
+
+#include "randomStream.hh"
+
+//---------------------------------------------------------------
+// Description
+// This class holds one set of ghosts, generated once per event, that
+// several explicit-ghost clusterings of the event can share instead of
+// each generating its own:
+//
+//   ghostSet ghosts(ghostRapMax, 0.005);
+//   ClusterSequenceActiveAreaExplicitGhosts cs(particles, jet_def,
+//      ghosts.getGhosts(), ghosts.getGhostArea());
+//
+// The ghosts are placed as the GhostedAreaSpec of fastjet 3 places them
+// (2*nRap+1 rows at irap*drap, nPhi columns, each ghost moved at random
+// within its cell, pt of about 1e-100; 15041 ghosts up to |y| = 6 for a
+// ghost area of 0.005), but with the random stream "ghostSet" of the
+// event instead of fastjet's generator, which all threads share: an
+// event gets the same ghosts whatever -nthreads, -shard or -skip.  For clusterings
+// where fastjet makes the ghosts itself (active_area), seeded() gives
+// the area definition a fixed seed from the stream "areaGhosts".
+//---------------------------------------------------------------
+
+class ghostSet {
+
+private :
+  double ghostRapMax_;
+  double ghostArea_;
+  std::vector<fastjet::PseudoJet> ghosts_;
+
+public :
+  ghostSet(double ghostRapMax, double ghostArea = 0.005) :
+    ghostRapMax_(ghostRapMax),
+    ghostArea_(ghostArea)
+  {
+    //the grid of GhostedAreaSpec: cells of about ghostArea, rows centred
+    //at irap*drap for irap = -nRap..nRap
+    double drap = std::sqrt(ghostArea);
+    int nPhi = int(std::ceil(2. * M_PI / drap));
+    double dphi = 2. * M_PI / nPhi;
+    int nRap = std::max(int(ghostRapMax_ / drap), 1);
+    drap = ghostRapMax_ / nRap;
+    ghostArea_ = drap * dphi;
+
+    randomStream rnd = randomService::stream("ghostSet");
+    ghosts_.reserve((2 * nRap + 1) * nPhi);
+    for(int irap = -nRap; irap <= nRap; irap++) {
+      for(int iphi = 0; iphi < nPhi; iphi++) {
+        double phi = (iphi + 0.5) * dphi + dphi * (rnd.uniform() - 0.5);
+        double rap = irap * drap + drap * (rnd.uniform() - 0.5);
+        double pt = 1e-100 * (1. + (rnd.uniform() - 0.5) * 0.1);
+        ghosts_.push_back(fastjet::PseudoJet(pt * std::cos(phi), pt * std::sin(phi),
+                                             pt * std::sinh(rap), pt * std::cosh(rap)));
+      }
+    }
+  }
+
+  //area with fastjet's ghosts generated from a fixed seed, drawn from
+  //the random stream of the event (with_fixed_seed came with fastjet
+  //3.1; with an older fastjet area is returned unchanged and its ghosts
+  //depend on the events clustered before)
+  static fastjet::AreaDefinition seeded(const fastjet::AreaDefinition &area) {
+#if FASTJET_VERSION_NUMBER >= 30100
+    //the two seeds of fastjet's generator (RANECU) are in [1, 2147483562]
+    //and [1, 2147483398]
+    randomStream rnd = randomService::stream("areaGhosts");
+    std::vector<int> seed(2);
+    seed[0] = 1 + int(rnd() % 2147483562ULL);
+    seed[1] = 1 + int(rnd() % 2147483398ULL);
+    return area.with_fixed_seed(seed);
+#else
+    return area;
+#endif
+  }
+
+  const std::vector<fastjet::PseudoJet> &getGhosts() const { return ghosts_; }
+  double getGhostArea()   const { return ghostArea_; }   //area per ghost
+  double getGhostRapMax() const { return ghostRapMax_; }
+};
+
+#endif
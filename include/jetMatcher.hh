@@ -10,6 +10,7 @@
 #include "fastjet/PseudoJet.hh"
 
 #include "jetCollection.hh"
+#include "stageTimer.hh"
 
 //---------------------------------------------------------------
 // Description
@@ -94,6 +95,8 @@ std::vector<int> jetMatcher::getTagMatchIds()  const
 
 void jetMatcher::matchJets()
 {
+   scopedTimer timer("jetMatcher");
+
    int nJets1 = (int)fjBase_.size();
    int nJets2 = (int)fjTag_.size();
 
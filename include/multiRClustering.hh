@@ -0,0 +1,134 @@
+#ifndef multiRClustering_h
+#define multiRClustering_h
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <thread>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequenceArea.hh"
+
+#include "jetCollection.hh"
+#include "ghostSet.hh"
+#include "stageTimer.hh"
+
+//---------------------------------------------------------------
+// Description
+// This class clusters one event for a list of jet radii (an R scan) and
+// returns one jetCollection per radius, in the order of the radii:
+//
+//   multiRClustering clustering({0.2, 0.4, 0.6}, 3.0, 10.);
+//   clustering.setInputParticles(particles);
+//   std::vector<jetCollection> jets = clustering.doClustering();
+//
+// The jets are the inclusive jets with pt > ptMin within |y| < jetRapMax,
+// sorted by pt, with active areas.  All radii get ghosts up to
+// |y| < ghostRapMax (6 by default, as the single-radius programs).  The
+// ghosts are fastjet's own (the jets keep no ghosts), from a seed of the
+// event (ghostSet::seeded).  With nThreads > 1 the radii
+// are clustered concurrently (fastjet must then be built with thread
+// safety); do not combine this with eventLoop workers unless there are
+// cores to spare.
+//
+// The jets refer to the cluster sequences kept here, so their
+// constituents are valid until the next setInputParticles() or until
+// the object is destroyed.
+//---------------------------------------------------------------
+
+class multiRClustering {
+
+private :
+  std::vector<double> radii_;
+  double jetRapMax_;
+  double ptMin_;
+  double ghostArea_;
+  int nThreads_;
+  double ghostRapMax_;
+  fastjet::JetAlgorithm algorithm_;
+  fastjet::RecombinationScheme scheme_;
+
+  std::vector<fastjet::PseudoJet> fjInputs_;
+  std::vector<std::unique_ptr<fastjet::ClusterSequenceArea>> cs_;
+
+  std::vector<fastjet::PseudoJet> clusterRadius(int i, const fastjet::AreaDefinition &area_def);
+
+public :
+  multiRClustering(const std::vector<double> &radii, double jetRapMax = 3.0, double ptMin = 0.,
+                   double ghostArea = 0.005, int nThreads = 1, double ghostRapMax = 6.0) :
+    radii_(radii),
+    jetRapMax_(jetRapMax),
+    ptMin_(ptMin),
+    ghostArea_(ghostArea),
+    nThreads_(nThreads < 1 ? 1 : nThreads),
+    ghostRapMax_(ghostRapMax),
+    algorithm_(fastjet::antikt_algorithm),
+    scheme_(fastjet::E_scheme)
+  {
+  }
+
+  void setAlgorithm(fastjet::JetAlgorithm algorithm, fastjet::RecombinationScheme scheme = fastjet::E_scheme) {
+    algorithm_ = algorithm;
+    scheme_ = scheme;
+  }
+
+  void setInputParticles(const std::vector<fastjet::PseudoJet> &v) {
+    fjInputs_ = v;
+    cs_.clear();
+  }
+
+  const std::vector<double> &getRadii() const { return radii_; }
+
+  std::vector<jetCollection> doClustering();
+};
+
+std::vector<fastjet::PseudoJet> multiRClustering::clusterRadius(int i, const fastjet::AreaDefinition &area_def)
+{
+  double R = radii_[i];
+  fastjet::JetDefinition jet_def(algorithm_, R, scheme_);
+
+  cs_[i].reset(new fastjet::ClusterSequenceArea(fjInputs_, jet_def, area_def));
+  return fastjet::sorted_by_pt(fastjet::SelectorAbsRapMax(jetRapMax_)(cs_[i]->inclusive_jets(ptMin_)));
+}
+
+std::vector<jetCollection> multiRClustering::doClustering()
+{
+  scopedTimer timer("multiRClustering");
+
+  int n = radii_.size();
+  cs_.clear();
+  cs_.resize(n);
+  std::vector<std::vector<fastjet::PseudoJet>> jets(n);
+
+  //the ghost seeds are drawn here, in the order of the radii, as the
+  //random streams belong to the thread of the event
+  std::vector<fastjet::AreaDefinition> areas;
+  for(int i = 0; i < n; i++) {
+    fastjet::GhostedAreaSpec ghost_spec(ghostRapMax_, 1, ghostArea_);
+    areas.push_back(ghostSet::seeded(fastjet::AreaDefinition(fastjet::active_area, ghost_spec)));
+  }
+
+  if(nThreads_ == 1 || n == 1) {
+    for(int i = 0; i < n; i++)
+      jets[i] = clusterRadius(i, areas[i]);
+  } else {
+    //from the end of the list (in an R scan the largest radii, with the
+    //most ghosts) to the start, handed out round robin
+    std::vector<std::thread> workers;
+    for(int t = 0; t < nThreads_ && t < n; t++) {
+      workers.push_back(std::thread([&, t]() {
+        for(int i = n - 1 - t; i >= 0; i -= nThreads_)
+          jets[i] = clusterRadius(i, areas[i]);
+      }));
+    }
+    for(std::thread &worker : workers)
+      worker.join();
+  }
+
+  std::vector<jetCollection> result;
+  for(int i = 0; i < n; i++)
+    result.push_back(jetCollection(jets[i]));
+  return result;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef nearestParticleFinder_h
+#define nearestParticleFinder_h
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "fastjet/PseudoJet.hh"
+
+//---------------------------------------------------------------
+// Description
+// This class finds the particle of a fixed set that is closest to a
+// given point in (rapidity, phi), with the distance of
+// PseudoJet::squared_distance (phi wraps around):
+//
+//   nearestParticleFinder finder(particles);
+//   double dist2;
+//   int i = finder.nearest(p, &dist2);    //particles[i], -1 if none
+//
+// The particles are put in a grid of cells of about cellSize in
+// rapidity and phi, and a query searches the cells in rings around
+// the cell of the point until no unsearched cell can be closer, so it
+// looks at the particles near the point instead of all of them.  The
+// distance is computed as in PseudoJet::squared_distance, so it is the
+// same to the last bit; of equally close particles the first is taken.
+//
+// remove(i) takes particle i out of the set in constant time (it is
+// swapped to the end of the particles of its cell) and restore() puts
+// all particles back, so one finder can be reused for many searches
+// that each use a particle at most once.
+//---------------------------------------------------------------
+
+class nearestParticleFinder {
+
+private :
+  double rapMin_;
+  double rapCell_;
+  double phiCell_;
+  int nRap_;
+  int nPhi_;
+  std::vector<double> rap_;
+  std::vector<double> phi_;
+  std::vector<int> cellStart_;                 //particles of cell c: cellIndex_[cellStart_[c]..cellStart_[c+1]]
+  std::vector<int> cellEnd_;                   //of which the ones not removed: cellIndex_[cellStart_[c]..cellEnd_[c]]
+  std::vector<int> cellIndex_;
+  std::vector<int> cell_;                      //cell of particle i
+  std::vector<int> position_;                  //position of particle i in cellIndex_
+  int nLeft_;
+
+  int rapBin(double rap) const {
+    int ir = int(std::floor((rap - rapMin_) / rapCell_));
+    return std::max(0, std::min(nRap_ - 1, ir));
+  }
+  int phiBin(double phi) const {
+    int ip = int(phi / phiCell_);
+    return std::max(0, std::min(nPhi_ - 1, ip));
+  }
+
+  void searchCell(int ir, int ip, double rap, double phi, int &best, double &bestDist2) const;
+
+public :
+  nearestParticleFinder(const std::vector<fastjet::PseudoJet> &particles, double cellSize = 0.1);
+
+  int size() const { return rap_.size(); }
+  //number of particles not removed
+  int nLeft() const { return nLeft_; }
+
+  void remove(int i);
+  void restore();
+
+  //index of the particle closest to p (-1 if there are none left), and
+  //its squared distance in dist2 (-1 if there are none left)
+  int nearest(const fastjet::PseudoJet &p, double *dist2 = 0) const { return nearest(p.rap(), p.phi(), dist2); }
+  int nearest(double rap, double phi, double *dist2 = 0) const;
+};
+
+nearestParticleFinder::nearestParticleFinder(const std::vector<fastjet::PseudoJet> &particles, double cellSize)
+  : rapMin_(0.),
+    rapCell_(cellSize),
+    nRap_(1),
+    nLeft_(particles.size())
+{
+  int n = particles.size();
+  rap_.reserve(n);
+  phi_.reserve(n);
+  for(const fastjet::PseudoJet &p : particles) {
+    rap_.push_back(p.rap());
+    phi_.push_back(p.phi());
+  }
+
+  nPhi_ = std::max(1, int(2. * M_PI / cellSize));
+  phiCell_ = 2. * M_PI / nPhi_;
+
+  if(n > 0) {
+    rapMin_ = *std::min_element(rap_.begin(), rap_.end());
+    double span = *std::max_element(rap_.begin(), rap_.end()) - rapMin_;
+    //not more rapidity cells than particles (a zero-pt particle has a
+    //rapidity of 1e5)
+    nRap_ = std::min(int(span / cellSize) + 1, 2 * n + 1);
+    if(span > 0.)
+      rapCell_ = std::max(cellSize, span / nRap_);
+  }
+
+  //count the particles per cell, then fill the cells in particle order
+  int nCell = nRap_ * nPhi_;
+  cell_.resize(n);
+  cellStart_.assign(nCell + 1, 0);
+  for(int i = 0; i < n; i++) {
+    cell_[i] = rapBin(rap_[i]) * nPhi_ + phiBin(phi_[i]);
+    cellStart_[cell_[i] + 1]++;
+  }
+  for(int c = 0; c < nCell; c++)
+    cellStart_[c + 1] += cellStart_[c];
+  cellIndex_.resize(n);
+  position_.resize(n);
+  std::vector<int> next(cellStart_.begin(), cellStart_.end() - 1);
+  for(int i = 0; i < n; i++) {
+    position_[i] = next[cell_[i]]++;
+    cellIndex_[position_[i]] = i;
+  }
+  cellEnd_.assign(cellStart_.begin() + 1, cellStart_.end());
+}
+
+void nearestParticleFinder::remove(int i)
+{
+  int c = cell_[i];
+  if(position_[i] >= cellEnd_[c])
+    return;                                    //removed before
+  //swap with the last particle of the cell that is not removed
+  int last = cellEnd_[c] - 1;
+  int j = cellIndex_[last];
+  cellIndex_[position_[i]] = j;
+  cellIndex_[last] = i;
+  position_[j] = position_[i];
+  position_[i] = last;
+  cellEnd_[c]--;
+  nLeft_--;
+}
+
+void nearestParticleFinder::restore()
+{
+  //the removed particles are still in their cells, after the others
+  std::copy(cellStart_.begin() + 1, cellStart_.end(), cellEnd_.begin());
+  nLeft_ = rap_.size();
+}
+
+void nearestParticleFinder::searchCell(int ir, int ip, double rap, double phi, int &best, double &bestDist2) const
+{
+  if(ir < 0 || ir >= nRap_)
+    return;
+  ip = ((ip % nPhi_) + nPhi_) % nPhi_;
+  int c = ir * nPhi_ + ip;
+  for(int k = cellStart_[c]; k < cellEnd_[c]; k++) {
+    int i = cellIndex_[k];
+    double dphi = std::abs(phi - phi_[i]);
+    if(dphi > M_PI)
+      dphi = 2. * M_PI - dphi;
+    double drap = rap - rap_[i];
+    double dist2 = dphi * dphi + drap * drap;
+    if(best < 0 || dist2 < bestDist2 || (dist2 == bestDist2 && i < best)) {
+      best = i;
+      bestDist2 = dist2;
+    }
+  }
+}
+
+int nearestParticleFinder::nearest(double rap, double phi, double *dist2) const
+{
+  int best = -1;
+  double bestDist2 = -1.;
+  if(nLeft_ > 0) {
+    phi = std::fmod(phi, 2. * M_PI);
+    if(phi < 0.)
+      phi += 2. * M_PI;
+
+    int ir0 = rapBin(rap);
+    int ip0 = phiBin(phi);
+    double cell = std::min(rapCell_, phiCell_);
+    int maxRing = std::max(nRap_, nPhi_ / 2 + 1);
+
+    for(int ring = 0; ring <= maxRing; ring++) {
+      //the cells at distance ring (in cells) from the cell of the point
+      bool allPhi = 2 * ring + 1 >= nPhi_;
+      for(int dr = -ring; dr <= ring; dr++) {
+        if(dr == -ring || dr == ring) {
+          if(allPhi)
+            for(int ip = 0; ip < nPhi_; ip++)
+              searchCell(ir0 + dr, ip, rap, phi, best, bestDist2);
+          else
+            for(int dp = -ring; dp <= ring; dp++)
+              searchCell(ir0 + dr, ip0 + dp, rap, phi, best, bestDist2);
+        } else {
+          searchCell(ir0 + dr, ip0 - ring, rap, phi, best, bestDist2);
+          searchCell(ir0 + dr, ip0 + ring, rap, phi, best, bestDist2);
+        }
+      }
+      //every particle not searched yet is at least ring cells away
+      if(best >= 0 && bestDist2 <= (ring * cell) * (ring * cell))
+        break;
+    }
+  }
+  if(dist2)
+    *dist2 = bestDist2;
+  return best;
+}
+
+#endif
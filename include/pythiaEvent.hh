@@ -9,13 +9,18 @@
 
 #include "Pythia8/Pythia.h"
 
-#include "extraInfo.hh"
+#include "../PU14/PU14.hh"
+
+#include "randomStream.hh"
 
 //using namespace std;
 
 //---------------------------------------------------------------
 // Description
 // This class generates a pythia8 event
+// Pythia draws its events in sequence from one seed, derived from the
+// job seed of randomService (option -seed), so the events depend on the
+// seed and on how many events were generated before
 // Author: M. Verweij
 //---------------------------------------------------------------
 
@@ -44,7 +49,8 @@ public :
     pythia.readString("Next:numberShowEvent = 0");
     pythia.readString(Form("Tune:pp = %d",tune_));
     pythia.readString("Random:setSeed = on");
-    pythia.readString("Random:seed = 0");
+    //Pythia takes seeds up to 900000000
+    pythia.readString(Form("Random:seed = %d",int(1 + randomService::stream(0,"pythiaEvent")() % 900000000)));
     if(partonLevel_) {
       pythia.readString("HadronLevel:all = off");
     }
@@ -62,7 +68,7 @@ public :
     for (int i = 0; i < pythia.event.size(); ++i) {
       if (pythia.event[i].isFinal()) {
         fastjet::PseudoJet p(pythia.event[i].px(),pythia.event[i].py(),pythia.event[i].pz(),pythia.event[i].e());
-        p.set_user_info(new extraInfo(pythia.event[i].id(), 0)); 
+        set_pu14_info(p, pythia.event[i].id(), 0);
         if(p.rap()>rapMin_ && p.rap()<rapMax_)
           particles.push_back(p);
       }
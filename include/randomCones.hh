@@ -12,8 +12,9 @@
 
 #include "fastjet/contrib/ConstituentSubtractor.hh"
 
+#include "randomStream.hh"
+
 #include "TVector2.h"
-#include "TRandom3.h"
 #include "TMath.h"
 
 using namespace std;
@@ -32,7 +33,6 @@ private :
   double rParam_;
   double etaMax_;
   std::vector<fastjet::PseudoJet> fjInputs_;
-  TRandom3 *rnd_;
 
   double deltaR(const double phi1, const double phi2, const double eta1, const double eta2);
 
@@ -47,16 +47,14 @@ public :
 randomCones::randomCones(unsigned int nCones, double rParam, double etaMax)
   : nCones_(nCones),
     rParam_(rParam),
-    etaMax_(etaMax),
-    rnd_()
+    etaMax_(etaMax)
 {
-  if(!rnd_) rnd_ = new TRandom3(0);
 }
 
 
 std::vector<fastjet::PseudoJet>  randomCones::run() {
-  
-  if(!rnd_) rnd_ = new TRandom3(0);
+
+  randomStream rnd = randomService::stream("randomCones");
     
   std::vector<fastjet::PseudoJet> cones;
   cones.reserve(nCones_);
@@ -67,8 +65,8 @@ std::vector<fastjet::PseudoJet>  randomCones::run() {
   for(unsigned int i = 0; i<nCones_; ++i) {
 
     //pick random position for random cone
-    double etaRC = rnd_->Rndm() * (etaMax_ - -1.*etaMax_) + -1.*etaMax_;
-    double phiRC = rnd_->Rndm() * (maxPhi - minPhi) + minPhi;
+    double etaRC = rnd.uniform() * (etaMax_ - -1.*etaMax_) + -1.*etaMax_;
+    double phiRC = rnd.uniform() * (maxPhi - minPhi) + minPhi;
 
     double ptRC = 0.;
     for(fastjet::PseudoJet part : fjInputs_) {
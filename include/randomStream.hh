@@ -0,0 +1,133 @@
+#ifndef randomStream_h
+#define randomStream_h
+
+#include <string>
+#include <map>
+#include <cmath>
+#include <cstdint>
+
+//---------------------------------------------------------------
+// Description
+// Random numbers that do not depend on the order in which events are
+// analysed.  A randomStream is a counter-based generator: its n-th
+// number is a hash of (key, n), so a stream needs no shared state and
+// two streams with different keys are independent.  The key is made
+// from the job seed (option -seed), the number of the hard event and
+// the name of the component that draws the numbers:
+//
+//   randomStream rnd = randomService::stream("randomCones");
+//   double eta = rnd.uniform(-etaMax, etaMax);
+//
+// randomService::stream() keys the stream with the event this thread
+// is analysing, which eventLoop sets to the number of the hard event in
+// its file (randomService::beginEvent), so an event gets the same
+// numbers with any -nthreads, -shard, -skip or -resume.  A component
+// that asks for a stream more than once in an event gets a different
+// one each time (in the same order in every job).  Outside eventLoop
+// the event is 0 unless the program calls beginEvent itself.
+//
+// randomStream is a UniformRandomBitGenerator, so it can also be used
+// with the std:: distributions.  The hash is the splitmix64 finalizer,
+// the generator is splitmix64 itself with the counter as its state.
+//---------------------------------------------------------------
+
+class randomStream {
+
+private :
+  uint64_t key_;
+  uint64_t counter_;
+
+public :
+  typedef uint64_t result_type;
+
+  static uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  explicit randomStream(uint64_t key = 0) : key_(key), counter_(0) {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~(result_type)0; }
+
+  result_type operator()() {
+    counter_++;
+    return mix(key_ + counter_ * 0x9e3779b97f4a7c15ULL);
+  }
+
+  //uniform in (0,1), never exactly 0 or 1
+  double uniform() { return ((*this)() >> 11) * (1. / 9007199254740992.) + (0.5 / 9007199254740992.); }
+  double uniform(double min, double max) { return min + (max - min) * uniform(); }
+
+  double gaus(double mean = 0., double sigma = 1.) {
+    double r = std::sqrt(-2. * std::log(uniform()));
+    return mean + sigma * r * std::cos(2. * M_PI * uniform());
+  }
+
+  //random direction with length r (as TRandom::Sphere)
+  void sphere(double &x, double &y, double &z, double r) {
+    z = uniform(-1., 1.);
+    double phi = uniform(0., 2. * M_PI);
+    double rxy = r * std::sqrt(1. - z * z);
+    x = rxy * std::cos(phi);
+    y = rxy * std::sin(phi);
+    z *= r;
+  }
+};
+
+class randomService {
+
+private :
+  struct eventState {
+    long long event;
+    std::map<std::string, uint64_t> used;     //streams handed out per component
+    eventState() : event(0) {}
+  };
+
+  static uint64_t &seed() {
+    static uint64_t s = 1;
+    return s;
+  }
+
+  static eventState &current() {
+    static thread_local eventState state;
+    return state;
+  }
+
+  static uint64_t hashName(const std::string &name) {
+    uint64_t h = 0xcbf29ce484222325ULL;       //FNV-1a
+    for(char c : name) {
+      h ^= (unsigned char)c;
+      h *= 0x100000001b3ULL;
+    }
+    return h;
+  }
+
+public :
+  //set once, before any stream is used
+  static void setSeed(uint64_t s) { seed() = s; }
+  static uint64_t getSeed()       { return seed(); }
+
+  //the streams this thread asks for from now on belong to event
+  static void beginEvent(long long event) {
+    eventState &state = current();
+    state.event = event;
+    state.used.clear();
+  }
+
+  static randomStream stream(long long event, const std::string &component, uint64_t occurrence = 0) {
+    uint64_t key = randomStream::mix(seed() + 0x9e3779b97f4a7c15ULL);
+    key = randomStream::mix(key ^ (uint64_t)event);
+    key = randomStream::mix(key ^ hashName(component));
+    key = randomStream::mix(key ^ occurrence);
+    return randomStream(key);
+  }
+
+  static randomStream stream(const std::string &component) {
+    eventState &state = current();
+    return stream(state.event, component, state.used[component]++);
+  }
+};
+
+#endif
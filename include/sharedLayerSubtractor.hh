@@ -9,6 +9,8 @@
 #include <map>
 #include <random>
 #include <numeric>
+#include <memory>
+#include <thread>
 
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
@@ -17,6 +19,11 @@
 #include "../PU14/PU14.hh"
 
 #include "Angularity.hh"
+#include "eventBackground.hh"
+#include "ghostSet.hh"
+#include "stageTimer.hh"
+#include "randomStream.hh"
+#include "nearestParticleFinder.hh"
 
 using namespace std;
 using namespace fastjet;
@@ -25,6 +32,14 @@ using namespace fastjet;
 // Description
 // This class runs the jet-by-jet shared layer subtraction
 // Author: M. Verweij, Y. Mehtar-Tani
+//
+// An initial condition adds the particle nearest to a random ghost of
+// the jet until it has the pt of a random UE; the nearest particle is
+// found with a nearestParticleFinder from which the particles used are
+// removed, and the pTD of the condition is summed up as particles are
+// added.  Each initial condition has its own random stream, so with
+// setNThreads(n) the initial conditions of all jets are made on n
+// threads with the same result.
 //---------------------------------------------------------------
 
 class sharedLayerSubtractor {
@@ -44,10 +59,65 @@ private :
 
   std::vector<fastjet::PseudoJet> fjJetParticles_;
 
-  std::random_device rd_;
+  eventBackground *background_;
+
   int nInitCond_;
   int nTopInit_;
-    
+  int nThreads_;
+
+  //a jet as the initial-condition search sees it
+  struct jetLayers {
+    fastjet::PseudoJet *jet;
+    std::vector<fastjet::PseudoJet> particles;
+    std::vector<double> ghostRap;
+    std::vector<double> ghostPhi;
+    std::vector<uint64_t> initCondKey;            //random stream of each initial condition
+    std::vector<std::vector<int>> collInitCond;   //particles of each initial condition
+    std::vector<double> chi2s;
+  };
+
+  //make initial condition ii of a jet (particles within the pt of a
+  //random UE, each the nearest to a random ghost) and its chi2
+  void makeInitCondition(jetLayers &layers, int ii, nearestParticleFinder &finder,
+                         double medPTD, double rmsPTD) const {
+
+    randomStream rnd(layers.initCondKey[ii]);
+    std::uniform_int_distribution<> distUni(0,layers.ghostRap.size()-1); //uniform distribution of ghosts in vector
+    std::vector<int> &initCondition = layers.collInitCond[ii];            //list of particles in initial condition
+
+    //get random maxPt for this initial condition
+    double maxPt = rnd.gaus(rho_, rhoSigma_)*layers.jet->area();
+
+    //a particle is not repeated inside the same initial condition
+    finder.restore();
+
+    //pt, pt^2 and momentum of the particles added, for pTD
+    double maxPtCurrent = 0.;
+    double sumPt2 = 0., sumPx = 0., sumPy = 0.;
+    while(maxPtCurrent<maxPt && finder.nLeft()>0) {
+
+      //pick random ghost and find closest particle to it
+      int ighost = distUni(rnd);
+      int ipSel = finder.nearest(layers.ghostRap[ighost], layers.ghostPhi[ighost]);
+      finder.remove(ipSel);
+
+      const fastjet::PseudoJet &partSel = layers.particles[ipSel];
+      initCondition.push_back(ipSel);
+      maxPtCurrent+=partSel.pt();
+      sumPt2 += partSel.pt2();
+      sumPx += partSel.px();
+      sumPy += partSel.py();
+    }
+
+    //pTD = sum pt^2 / pt^2 of the joined particles, as Angularity(0.,2.)
+    double chi2 = 1e6;
+    if(initCondition.size()>0) {
+      double ptDCur = sumPt2/(sumPx*sumPx + sumPy*sumPy);
+      chi2 = fabs(ptDCur-medPTD)*(fabs(ptDCur-medPTD))/rmsPTD/rmsPTD;
+    }
+    layers.chi2s[ii] = chi2;
+  }
+
 public :
   sharedLayerSubtractor(double rJet = 0.4,
                         double ghostArea = 0.005,
@@ -59,17 +129,28 @@ public :
     ghostArea_(ghostArea),
     ghostRapMax_(ghostRapMax),
     jetRapMax_(jetRapMax),
+    background_(0),
     nInitCond_(nInitCond),
-    nTopInit_(nTopInit)
+    nTopInit_(nTopInit),
+    nThreads_(1)
   {
 
   }
 
   void setGhostArea(double a) { ghostArea_ = a; }
 
+  //make the initial conditions on nThreads threads
+  void setNThreads(int n) { nThreads_ = n < 1 ? 1 : n; }
+
   void setInputParticles(std::vector<fastjet::PseudoJet> v) { fjInputs_ = v; }
+  //anti-kt jets of the input particles clustered with explicit ghosts,
+  //to reuse a clustering the caller already has (see csSubtractor)
   void setInputJets(std::vector<fastjet::PseudoJet> v)      { fjJetInputs_ = v; }
 
+  //use the background estimate of the event instead of making one
+  //(it must have been given the same input particles)
+  void setBackground(eventBackground *b) { background_ = b; }
+
   double getRho()  const { return rho_; }
   double getRhoSigma() const { return rhoSigma_; }
 
@@ -78,45 +159,46 @@ public :
 
   std::vector<fastjet::PseudoJet> doSubtraction() {
 
+    scopedTimer timer("sharedLayerSubtractor");
+
     //if(fjJetInputs_.size()==0 && fjInputs_.size()) {
     //  throw "You didn't give me input jets or particles. You should give me one of the two";
     //  return std::vector<fastjet::PseudoJet>();
     //}
 
-    fastjet::GhostedAreaSpec ghost_spec(ghostRapMax_, 1, ghostArea_);
+    //ghosts of the event, for the jets and the subtracted jets
+    ghostSet eventGhosts(ghostRapMax_, ghostArea_);
 
-    std::vector<fastjet::PseudoJet> jets = fjJetInputs_;
-    //if(jets.size()==0) {
-
-    // do the clustering with ghosts and get the jets
+    // get the jets with ghosts: given, or clustered here
     //----------------------------------------------------------
-    fastjet::JetDefinition jet_def(antikt_algorithm, jetRParam_);
-    fastjet::AreaDefinition area_def = fastjet::AreaDefinition(fastjet::active_area_explicit_ghosts,ghost_spec);
-
-    fastjet::ClusterSequenceArea cs(fjInputs_, jet_def, area_def);
     fastjet::Selector jet_selector = SelectorAbsRapMax(jetRapMax_);
-    jets = fastjet::sorted_by_pt(jet_selector(cs.inclusive_jets()));
+    std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts> cs;
+    std::vector<fastjet::PseudoJet> jets;
+    if(fjJetInputs_.size() > 0) {
+      jets = fastjet::sorted_by_pt(jet_selector(fjJetInputs_));
+    } else {
+      fastjet::JetDefinition jet_def(antikt_algorithm, jetRParam_);
+      cs.reset(new fastjet::ClusterSequenceActiveAreaExplicitGhosts(fjInputs_, jet_def,
+                                                                    eventGhosts.getGhosts(), eventGhosts.getGhostArea()));
+      jets = fastjet::sorted_by_pt(jet_selector(cs->inclusive_jets()));
+    }
 
     fastjet::JetDefinition jet_defSub(antikt_algorithm, 999.);
-    fastjet::ClusterSequenceArea csSub(fjInputs_, jet_defSub, area_def);
     
-    // create what we need for the background estimation
+    // background estimation, shared with the other subtractors of the
+    // event if setBackground was called
     //----------------------------------------------------------
-    fastjet::JetDefinition jet_def_bkgd(fastjet::kt_algorithm, 0.4);
-    fastjet::AreaDefinition area_def_bkgd(fastjet::active_area_explicit_ghosts,ghost_spec);
-    fastjet::Selector selector = fastjet::SelectorAbsRapMax(jetRapMax_-0.4) * (!fastjet::SelectorNHardest(2));
+    eventBackground ownBackground(ghostRapMax_, ghostArea_, jetRapMax_-0.4);
+    eventBackground *background = background_;
+    if(background == 0) {
+      ownBackground.setInputParticles(fjInputs_);
+      background = &ownBackground;
+    }
 
-    fastjet::ClusterSequenceArea csKt(fjInputs_, jet_def_bkgd, area_def_bkgd);
-    std::vector<fastjet::PseudoJet> bkgd_jets = fastjet::sorted_by_pt(selector(csKt.inclusive_jets()));
-    
-    fastjet::JetMedianBackgroundEstimator bkgd_estimator(selector, jet_def_bkgd, area_def_bkgd);
-    bkgd_estimator.set_particles(fjInputs_);
-    bkgd_estimator.set_jets(bkgd_jets);
+    const std::vector<fastjet::PseudoJet> &bkgd_jets = background->getJets();
     
-    rho_ = bkgd_estimator.rho();
-    rhoSigma_ = bkgd_estimator.sigma();
-
-    if(rho_ < 0)    rho_ = 0;
+    rho_ = background->getRho();
+    rhoSigma_ = background->getSigma();
 
     //std::cout << "rho: " << rho_ << "  rhoSigma: " << rhoSigma_ << std::endl;
     
@@ -129,7 +211,7 @@ public :
     Angularity pTD(0.,2.,0.4);
 
     std::vector<double> pTD_bkgd;
-    for(fastjet::PseudoJet& jet : bkgd_jets) {
+    for(const fastjet::PseudoJet& jet : bkgd_jets) {
       pTD_bkgd.push_back(pTD.result(jet));
     }
     std::nth_element(pTD_bkgd.begin(), pTD_bkgd.begin() + pTD_bkgd.size()/2, pTD_bkgd.end());
@@ -149,95 +231,68 @@ public :
 
     //std::cout << "med_pTD: " << med_pTD << "  rms_pTD: " << rms_pTD << std::endl;
     
-    std::mt19937 rndSeed(rd_()); //rnd number generator seed
+    randomStream rndSeed = randomService::stream("sharedLayerSubtractor"); //rnd number generator
            
-    std::vector<fastjet::PseudoJet> subtracted_jets;
-    subtracted_jets.reserve(jets.size());
-    int ijet = -1;
+    // get ghosts and true particles of the jets (ghosts are distributed
+    // uniformly which we will use to create initial conditions)
+    //----------------------------------------------------------
+    std::vector<jetLayers> jetList;
+    jetList.reserve(jets.size());
     for(fastjet::PseudoJet& jet : jets) {
-      ++ijet;
-      //if(ijet>1) continue; //TEMP,DEBUG
-      // std::cout << "start jet loop. entry: " << ijet << "/" << jets.size() << " pt: " << jet.pt() << " eta: " << jet.eta() << std::endl;
-
       if(jet.is_pure_ghost()) continue;
-      
-      //get ghosts and true particles (ghosts are distributed uniformly which we will use to create initial conditions)
-      //----------------------------------------------------------
+
       std::vector<fastjet::PseudoJet> particles, ghosts;
       fastjet::SelectorIsPureGhost().sift(jet.constituents(), ghosts, particles);
-      if(particles.size()<1 || jet.pt()<1.) continue;
-      
-      //set user_index of all particles to position particles vector
-      for(int i = 0; i<(int)particles.size(); ++i) {
-        particles[i].set_user_index(i);
+      if(particles.size()<1 || ghosts.size()<1 || jet.pt()<1.) continue;
+
+      jetList.push_back(jetLayers());
+      jetLayers &layers = jetList.back();
+      layers.jet = &jet;
+      layers.particles = particles;
+      for(const fastjet::PseudoJet &ghost : ghosts) {
+        layers.ghostRap.push_back(ghost.rap());
+        layers.ghostPhi.push_back(ghost.phi());
       }
-      
-      // create requested number of initial conditions
-      //----------------------------------------------------------
-      std::vector<std::vector<int>> collInitCond;
-      for(int ii = 0; ii<nInitCond_; ++ii) {
-
-        std::uniform_int_distribution<> distUni(0,ghosts.size()); //uniform distribution of ghosts in vector
-        std::vector<int> initCondition;                           //list of particles in initial condition
-
-        //get random maxPt for this initial condition
-        double maxPt = gausDist(rndSeed)*jet.area();
-
-        //make copy of particles so that a particle is not repeated inside the same initial condition
-        std::vector<fastjet::PseudoJet> particlesNotUsed = particles;
-        
-        double maxPtCurrent = 0.;
-        while(maxPtCurrent<maxPt && particlesNotUsed.size()>0) {
-
-          //pick random ghost
-          int ighost = int(std::floor(distUni(rndSeed))); 
-        
-          //find closest particle to ghost
-          double dR2 = 1000.;
-          fastjet::PseudoJet partSel;
-          int ipSel = -1;
-          for(int ip = 0; ip<(int)particlesNotUsed.size(); ++ip) {
-            fastjet::PseudoJet part = particlesNotUsed[ip];
-            double dR2Cur = ghosts[ighost].squared_distance(part);
-            if(dR2Cur < dR2) {
-              dR2 = dR2Cur;
-              partSel = part;
-              ipSel = ip;
-            }
-          }
-          if(ipSel<0) continue; //this shouldn't happen
-          initCondition.push_back(partSel.user_index());
-          maxPtCurrent+=partSel.pt();
-          particlesNotUsed.erase(particlesNotUsed.begin()+ipSel);
-          //std::cout << "Added new particle with pt = " << partSel.pt() << " to init condition. total pt now " << maxPtCurrent << "/" << maxPt << std::endl;
-        }
-        collInitCond.push_back(initCondition);
-      }//initial conditions loop
-     
-      //----------------------------------------------------------
-      //Now we have the requested number of random initial condition
-      
-      //Next step: calc chi2 for each initial condition
-      //----------------------------------------------------------
-      std::vector<double> chi2s;
-      for(int ii = 0; ii<nInitCond_; ++ii) {
-        std::vector<int> indices = collInitCond[ii];
-        double chi2 = 1e6;
-        if(indices.size()>0) { 
-          std::vector<fastjet::PseudoJet> combinedparticles;
-          for(int ic = 0; ic<(int)indices.size(); ++ic) {
-            combinedparticles.push_back(particles[indices[ic]]);
-          }
-          fastjet::PseudoJet currInitJet = fastjet::PseudoJet(join(combinedparticles));
-          //std::cout << "get pTD from ID" << std::endl;
-          double ptDCur = pTD.result(currInitJet);
-          chi2 = fabs(ptDCur-med_pTD)*(fabs(ptDCur-med_pTD))/rms_pTD/rms_pTD;
+      for(int ii = 0; ii<nInitCond_; ++ii)
+        layers.initCondKey.push_back(rndSeed());
+      layers.collInitCond.resize(nInitCond_);
+      layers.chi2s.resize(nInitCond_);
+    }
+
+    // create requested number of initial conditions and calc chi2 for
+    // each of them, handed out round robin to the threads
+    //----------------------------------------------------------
+    int nItem = jetList.size()*nInitCond_;
+    auto makeInitConditions = [&](int first) {
+      std::unique_ptr<nearestParticleFinder> finder;
+      int finderJet = -1;
+      for(int item = first; item < nItem; item += nThreads_) {
+        int ij = item/nInitCond_;
+        if(ij != finderJet) {
+          finder.reset(new nearestParticleFinder(jetList[ij].particles));
+          finderJet = ij;
         }
-        chi2s.push_back(chi2);
-        //std::cout << "chi2 of initial condition " << ii << " is " << chi2 << " with " <<  combinedparticles.size() << " particles" << std::endl;
+        makeInitCondition(jetList[ij], item%nInitCond_, *finder, med_pTD, rms_pTD);
       }
-      
-      
+    };
+    if(nThreads_ == 1 || nItem < 2) {
+      makeInitConditions(0);
+    } else {
+      std::vector<std::thread> workers;
+      for(int t = 0; t < nThreads_ && t < nItem; t++)
+        workers.push_back(std::thread(makeInitConditions, t));
+      for(std::thread &worker : workers)
+        worker.join();
+    }
+
+    std::vector<fastjet::PseudoJet> subtracted_jets;
+    subtracted_jets.reserve(jetList.size());
+    for(jetLayers &layers : jetList) {
+      fastjet::PseudoJet &jet = *layers.jet;
+      const std::vector<fastjet::PseudoJet> &particles = layers.particles;
+      const std::vector<std::vector<int>> &collInitCond = layers.collInitCond;
+      const std::vector<double> &chi2s = layers.chi2s;
+
       //sort the chi2s keeping track of indices
       //----------------------------------------------------------
       // initialize original index locations
@@ -254,11 +309,9 @@ public :
       std::vector<int> share_idx(particles.size(),0);
       for(int it = 0; it<nTopInit_; ++it) {
         int chi2Index = idx[it];
-        std::vector<int> indices = collInitCond[chi2Index];
+        const std::vector<int> &indices = collInitCond[chi2Index];
         for(int ic = 0; ic<(int)indices.size(); ++ic) {
-          share_idx[particles[indices[ic]].user_index()]++;
-          //std::cout << "indices[ic] = " << indices[ic] << "  user_index = " << particles[indices[ic]].user_index() << std::endl;
-          //std::cout << "share_idx current: " << share_idx[particles[indices[ic]].user_index()] << std::endl;
+          share_idx[indices[ic]]++;
         }
       }
       
@@ -289,7 +342,9 @@ public :
       }
 
       if(fjJetParticles_.size()>0) {
-        fastjet::ClusterSequenceArea *csSub = new fastjet::ClusterSequenceArea(fjJetParticles_, jet_defSub, area_def);
+        fastjet::ClusterSequenceActiveAreaExplicitGhosts *csSub =
+          new fastjet::ClusterSequenceActiveAreaExplicitGhosts(fjJetParticles_, jet_defSub,
+                                                               eventGhosts.getGhosts(), eventGhosts.getGhostArea());
         std::vector<fastjet::PseudoJet> jetSub = fastjet::sorted_by_pt(csSub->inclusive_jets());
         if(jetSub[0].pt()>0.) subtracted_jets.push_back(jetSub[0]);
         if(subtracted_jets.size()>0 && subtracted_jets.size()<2) csSub->delete_self_when_unused();
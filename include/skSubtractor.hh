@@ -6,12 +6,15 @@
 #include <string>
 #include <algorithm>
 #include <fstream>
+#include <cmath>
 
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
 #include "fastjet/contrib/SoftKiller.hh"
 
+#include "stageTimer.hh"
+
 using namespace std;
 using namespace fastjet;
 
@@ -19,6 +22,20 @@ using namespace fastjet;
 // Description
 // This class runs soft killer on the full event
 // Author: M. Verweij
+//
+// Constructed with a list of grid sizes it runs a scan instead:
+//
+//   skSubtractor skScan({0.2, 0.3, 0.4}, 3.);
+//   skScan.setInputParticles(particles);
+//   std::vector<double> thresholds = skScan.doThresholds();
+//   std::vector<fastjet::PseudoJet> skEvent = skScan.getSubtractedEvent(1);
+//
+// doThresholds() fills the maximal pt of the cells of all grids in one
+// pass over the particles and takes the median for each grid, binned
+// and rounded as contrib::SoftKiller (RectangularGrid) does, so the
+// thresholds and subtracted events are the ones doSubtraction() gives
+// for each grid size.  getSubtractedEvent(i) copies only the particles
+// kept with grid size i.
 //---------------------------------------------------------------
 
 class skSubtractor {
@@ -27,6 +44,8 @@ private :
   double gridSize_;
   double rapMax_;
   double ptThreshold_;
+  std::vector<double> gridSizes_;           //grid scan
+  std::vector<double> ptThresholds_;
   std::vector<fastjet::PseudoJet> fjInputs_;
 
   contrib::SoftKiller subtractor_;
@@ -42,12 +61,25 @@ public :
     subtractor_ = contrib::SoftKiller(rapMax_,gridSize_);
   }
 
+  skSubtractor(const std::vector<double> &gridSizes, double rapMax = 3.) :
+    gridSize_(gridSizes.size() > 0 ? gridSizes[0] : 0.4),
+    rapMax_(rapMax),
+    ptThreshold_(),
+    gridSizes_(gridSizes)
+  {
+    subtractor_ = contrib::SoftKiller(rapMax_,gridSize_);
+  }
+
   void setInputParticles(std::vector<fastjet::PseudoJet> v) { fjInputs_ = v; }
 
   double getPtThreshold()  const { return ptThreshold_; }
+  const std::vector<double> &getGridSizes()    const { return gridSizes_; }
+  const std::vector<double> &getPtThresholds() const { return ptThresholds_; }
   
   std::vector<fastjet::PseudoJet> doSubtraction() {
 
+    scopedTimer timer("skSubtractor");
+
     std::vector<fastjet::PseudoJet> skEvent;
     subtractor_.apply(fjInputs_, skEvent, ptThreshold_);
 
@@ -55,6 +87,73 @@ public :
     
     return skEvent;
   }
+
+  //grid scan: the threshold for each grid size
+  std::vector<double> doThresholds();
+
+  //grid scan: the particles kept with grid size i (after doThresholds)
+  std::vector<fastjet::PseudoJet> getSubtractedEvent(int i) const;
 };
 
+std::vector<double> skSubtractor::doThresholds()
+{
+  scopedTimer timer("skSubtractor");
+
+  //the grids of contrib::SoftKiller: cells of about the grid size,
+  //|y| < rapMax_
+  int nGrid = gridSizes_.size();
+  double twoPi = 2. * M_PI;
+  std::vector<int> nRap(nGrid), nPhi(nGrid);
+  std::vector<double> invDRap(nGrid), invDPhi(nGrid);
+  std::vector<std::vector<double>> maxPt2(nGrid);
+  for(int ig = 0; ig < nGrid; ++ig) {
+    nRap[ig] = std::max(int(2. * rapMax_ / gridSizes_[ig] + 0.5), 1);
+    invDRap[ig] = nRap[ig] / (2. * rapMax_);
+    nPhi[ig] = int(twoPi / gridSizes_[ig] + 0.5);
+    invDPhi[ig] = nPhi[ig] / twoPi;
+    maxPt2[ig].assign(nRap[ig] * nPhi[ig], 0.);
+  }
+
+  for(const fastjet::PseudoJet &p : fjInputs_) {
+    double y = p.rap() + rapMax_;
+    if(y < 0.)
+      continue;
+    double phi = p.phi();
+    double pt2 = p.pt2();
+    for(int ig = 0; ig < nGrid; ++ig) {
+      int iy = int(y * invDRap[ig]);
+      if(iy >= nRap[ig])
+        continue;
+      int iphi = int(phi * invDPhi[ig]);
+      if(iphi == nPhi[ig])
+        iphi = 0;
+      double &cellMax = maxPt2[ig][iy * nPhi[ig] + iphi];
+      if(pt2 > cellMax)
+        cellMax = pt2;
+    }
+  }
+
+  //median of the cell maxima
+  ptThresholds_.assign(nGrid, 0.);
+  for(int ig = 0; ig < nGrid; ++ig) {
+    std::vector<double> &cells = maxPt2[ig];
+    std::nth_element(cells.begin(), cells.begin() + cells.size()/2, cells.end());
+    ptThresholds_[ig] = std::sqrt(cells[cells.size()/2]);
+  }
+  if(nGrid > 0)
+    ptThreshold_ = ptThresholds_[0];
+  return ptThresholds_;
+}
+
+std::vector<fastjet::PseudoJet> skSubtractor::getSubtractedEvent(int i) const
+{
+  //as contrib::SoftKiller, the particle at the threshold is removed too
+  double pt2cut = (1+1e-12) * ptThresholds_[i] * ptThresholds_[i];
+  std::vector<fastjet::PseudoJet> skEvent;
+  for(const fastjet::PseudoJet &p : fjInputs_)
+    if(p.pt2() >= pt2cut)
+      skEvent.push_back(p);
+  return skEvent;
+}
+
 #endif
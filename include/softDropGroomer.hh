@@ -13,6 +13,7 @@
 
 #include "jetCollection.hh"
 #include "jewelMatcher.hh"
+#include "stageTimer.hh"
 
 //---------------------------------------------------------------
 // Description
@@ -120,6 +121,8 @@ std::vector<fastjet::PseudoJet> softDropGroomer::doGrooming(std::vector<fastjet:
 
 std::vector<fastjet::PseudoJet> softDropGroomer::doGrooming()
 {
+   scopedTimer timer("softDropGroomer");
+
    fjOutputs_.reserve(fjInputs_.size());
    zg_.reserve(fjInputs_.size());
    drBranches_.reserve(fjInputs_.size());
@@ -214,6 +217,8 @@ std::vector<fastjet::PseudoJet> softDropGroomer::doGroomingWithJewelSub(std::vec
 
 std::vector<fastjet::PseudoJet> softDropGroomer::doGroomingWithJewelSub(std::vector<fastjet::PseudoJet> particlesDummy)
 {
+   scopedTimer timer("softDropGroomer");
+
    fjOutputs_.reserve(fjInputs_.size());
    zg_.reserve(fjInputs_.size());
    drBranches_.reserve(fjInputs_.size());
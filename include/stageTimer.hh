@@ -0,0 +1,222 @@
+#ifndef stageTimer_h
+#define stageTimer_h
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+
+#include "treeWriter.hh"
+
+//---------------------------------------------------------------
+// Description
+// Timers and counters for the stages of the analysis (event reading,
+// clustering, subtraction, grooming, matching, writing the tree).
+// A stage is timed by a scopedTimer that lives for the duration of the
+// stage:
+//
+//   {
+//     scopedTimer timer("csSubtractor");
+//     ...
+//   }
+//   stageTimer::count("particles", particles.size());
+//
+// Nothing is recorded unless stageTimer::enable() was called (options
+// -timing and -timingtree of the run programs); a disabled scopedTimer
+// does not read the clock.  eventLoop prints the summary table at the
+// end of the job, and with perEvent it also writes the time of each
+// stage run inside the analysis of the event (between beginEvent() and
+// writeEvent()) to the branch <stage>Time of the output tree (0 in the
+// events that did not run the stage, empty in those written before the
+// stage was first run).
+// Stages may nest (the time of a subtractor includes the background
+// estimate it triggers).
+// Timers may be used from the eventLoop worker threads; the times of a
+// stage are then summed over the threads and can exceed the wall time.
+//---------------------------------------------------------------
+
+class stageTimer {
+
+private :
+  struct stageStats {
+    long long calls;
+    double seconds;
+    long long count;
+    bool inEvent;                                     //ever timed inside an event
+  };
+
+  struct registry {
+    bool enabled;
+    bool perEvent;
+    std::mutex mutex;
+    std::vector<std::string> order;                   //stages in order of first use
+    std::map<std::string, stageStats> stats;
+    std::chrono::steady_clock::time_point start;
+    registry() : enabled(false), perEvent(false) {}
+  };
+
+  static registry &get() {
+    static registry r;
+    return r;
+  }
+
+  //times of the stages in the event being analysed by this thread
+  static std::map<std::string, double> &eventTimes() {
+    static thread_local std::map<std::string, double> times;
+    return times;
+  }
+
+  static bool &inEvent() {
+    static thread_local bool in = false;
+    return in;
+  }
+
+  static stageStats &statsFor(const std::string &stage) {
+    registry &r = get();
+    std::map<std::string, stageStats>::iterator it = r.stats.find(stage);
+    if(it == r.stats.end()) {
+      r.order.push_back(stage);
+      stageStats empty = {0, 0., 0, false};
+      it = r.stats.insert(std::make_pair(stage, empty)).first;
+    }
+    return it->second;
+  }
+
+public :
+  static void enable(bool on = true, bool perEvent = false) {
+    registry &r = get();
+    r.enabled = on;
+    r.perEvent = on && perEvent;
+    r.start = std::chrono::steady_clock::now();
+  }
+
+  static bool isEnabled()  { return get().enabled; }
+  static bool isPerEvent() { return get().perEvent; }
+
+  static void addTime(const std::string &stage, double seconds) {
+    registry &r = get();
+    if(!r.enabled)
+      return;
+    bool event = r.perEvent && inEvent();
+    {
+      std::lock_guard<std::mutex> lock(r.mutex);
+      stageStats &s = statsFor(stage);
+      s.calls++;
+      s.seconds += seconds;
+      if(event)
+        s.inEvent = true;
+    }
+    if(event)
+      eventTimes()[stage] += seconds;
+  }
+
+  static void count(const std::string &stage, long long n = 1) {
+    registry &r = get();
+    if(!r.enabled)
+      return;
+    std::lock_guard<std::mutex> lock(r.mutex);
+    statsFor(stage).count += n;
+  }
+
+  //the stages this thread times from now on belong to its current event
+  static void beginEvent() { inEvent() = true; }
+
+  //writes the stage times of this thread's event to w and resets them
+  static void writeEvent(treeWriter &w);
+
+  static void printSummary(std::ostream &os = std::cout);
+};
+
+//---------------------------------------------------------------
+// times the scope it lives in (or until stop()) as the given stage
+//---------------------------------------------------------------
+
+class scopedTimer {
+
+private :
+  const char *stage_;
+  bool running_;
+  std::chrono::steady_clock::time_point start_;
+
+public :
+  scopedTimer(const char *stage) :
+    stage_(stage),
+    running_(stageTimer::isEnabled())
+  {
+    if(running_)
+      start_ = std::chrono::steady_clock::now();
+  }
+
+  ~scopedTimer() { stop(); }
+
+  void stop() {
+    if(!running_)
+      return;
+    running_ = false;
+    stageTimer::addTime(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>
+                        (std::chrono::steady_clock::now() - start_).count() / 1e9);
+  }
+};
+
+void stageTimer::writeEvent(treeWriter &w)
+{
+  registry &r = get();
+  inEvent() = false;
+  if(!r.perEvent)
+    return;
+
+  //every stage of an event so far, so a stage the event did not run is 0
+  //instead of keeping the value of the previous event
+  std::vector<std::string> stages;
+  {
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for(const std::string &stage : r.order)
+      if(r.stats[stage].inEvent)
+        stages.push_back(stage);
+  }
+
+  std::map<std::string, double> &times = eventTimes();
+  for(const std::string &stage : stages)
+    w.addCollection(stage + "Time", std::vector<double>(1, times[stage]));
+  times.clear();
+}
+
+void stageTimer::printSummary(std::ostream &os)
+{
+  registry &r = get();
+  if(!r.enabled)
+    return;
+
+  double wall = std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now() - r.start).count() / 1e9;
+
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  os << std::endl;
+  os << "Timing per stage (wall time " << std::fixed << std::setprecision(2) << wall << " s)" << std::endl;
+  os << std::setw(28) << std::left << "stage" << std::right
+     << std::setw(10) << "calls" << std::setw(12) << "total [s]"
+     << std::setw(12) << "ms/call" << std::setw(10) << "% wall"
+     << std::setw(14) << "count" << std::endl;
+  for(const std::string &stage : r.order) {
+    const stageStats &s = r.stats[stage];
+    os << std::setw(28) << std::left << stage << std::right;
+    if(s.calls > 0)
+      os << std::setw(10) << s.calls
+         << std::setw(12) << std::setprecision(3) << s.seconds
+         << std::setw(12) << s.seconds * 1000 / s.calls
+         << std::setw(10) << std::setprecision(1) << (wall > 0 ? 100 * s.seconds / wall : 0.);
+    else
+      os << std::setw(44) << "";
+    if(s.count > 0)
+      os << std::setw(14) << s.count;
+    os << std::endl;
+  }
+  os.unsetf(std::ios::fixed);
+  os << std::setprecision(6);
+}
+
+#endif
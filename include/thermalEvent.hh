@@ -7,12 +7,12 @@
 #include <algorithm>
 #include <fstream>
 
-#include "extraInfo.hh"
+#include "../PU14/PU14.hh"
 
 //ROOT stuff
-#include <TRandom3.h>
 #include <TMath.h>
-#include "TF1.h"
+
+#include "randomStream.hh"
 
 using namespace fastjet;
 using namespace std;
@@ -20,6 +20,8 @@ using namespace std;
 //---------------------------------------------------------------
 // Description
 // This class generates a thermal event following Boltzman distribution
+// pt*exp(-2*pt/meanpt) for 0.2 < pt < 200 GeV/c, drawing each event
+// from a stream of randomService
 // Author: M. Verweij
 //---------------------------------------------------------------
 
@@ -31,7 +33,6 @@ private :
   double            rapMin_;
   double            rapMax_;
   double            neutralFrac_;
-  TF1              *funcThrm_;
 
 public :
   thermalEvent(unsigned int mult = 12000, double meanpt = 0.7, double rapMin = -3., double rapMax = 3.,double neutralFrac = 0.33) :
@@ -41,10 +42,6 @@ public :
     rapMax_(rapMax),
     neutralFrac_(neutralFrac)
   {
-    
-    funcThrm_ = new TF1("funcThrm_","[0]*TMath::Power([1], 2)*x*TMath::Exp(-[1]*x)", 0.2, 200.);
-    funcThrm_->SetParNames("Amplitude", "b (GeV/c)^{-1}");
-    funcThrm_->SetParameters(1.,2./meanpt_);
   }
 
   void setMult(unsigned int m) { mult_ = m; }
@@ -53,30 +50,37 @@ public :
   
   std::vector<fastjet::PseudoJet> createThermalEvent() {
 
+    randomStream rnd = randomService::stream("thermalEvent");
+    double b = 2./meanpt_;
+
     std::vector<fastjet::PseudoJet> particles;
 
     for(unsigned int i = 0; i<mult_; ++i) {
-      double pt = funcThrm_->GetRandom();
+      //x*exp(-b*x) is the distribution of the sum of two exponentials
+      double pt = 0.;
+      do {
+        pt = -(std::log(rnd.uniform()) + std::log(rnd.uniform()))/b;
+      } while(pt<0.2 || pt>200.);
       //random phi
       double phimin = 0.;
       double phimax = TMath::TwoPi();
-      double phi = gRandom->Rndm() * (phimax - phimin) + phimin;
+      double phi = rnd.uniform() * (phimax - phimin) + phimin;
       //random rapidity
-      double rap = gRandom->Rndm() * (rapMax_ - rapMin_) + rapMin_;
+      double rap = rnd.uniform() * (rapMax_ - rapMin_) + rapMin_;
 
       int pdgid = 22;
       double mass = 0.0;
-      if(gRandom->Rndm()>neutralFrac_) {
+      if(rnd.uniform()>neutralFrac_) {
         mass = 0.1395;
         int charge = 1;
-        if(gRandom->Rndm()<0.5) charge = -1;
+        if(rnd.uniform()<0.5) charge = -1;
         pdgid = charge*211;
       }
       //std::cout << "mass: " << mass << std::endl;
       
       fastjet::PseudoJet p4;
       p4.reset_momentum_PtYPhiM(pt,rap,phi,mass);
-      p4.set_user_info(new extraInfo(pdgid, 1));
+      set_pu14_info(p4, pdgid, 1);
       
       particles.push_back(p4);
     }
@@ -9,6 +9,8 @@
 #include <map>
 
 #include "TTree.h"
+#include "TFile.h"
+#include "TParameter.h"
 
 #include "fastjet/PseudoJet.hh"
 
@@ -20,6 +22,15 @@
 // Only accepts vectors of the following types: int, double, fastjet::PseudoJet
 // In case of PseudoJet it will store pt, eta, phi and mass as separate vectors
 // in the output tree
+// A treeWriter made with withTree = false has no tree and only collects the
+// values of one event, which takeEvent() then moves into a writer with a
+// tree (used by eventLoop to let each worker thread fill its own buffer)
+// With openFile() the tree is written to its file as it is filled, and
+// checkpoint() makes what has been filled so far readable from the file,
+// even if the job dies later.  openFile() with resume picks up the tree of
+// the last checkpoint, so the job can continue after the events in it
+// A branch that is first set after some events have been filled has an
+// empty vector in those events
 // Authors: Y. Chen, M. Verweij
 //---------------------------------------------------------------
 
@@ -28,6 +39,9 @@ class treeWriter
 private :
   TTree* treeOut_;
   const char *treeName_;
+  TFile *file_;
+  bool resumed_;
+  std::map<std::string,void*> resumedBranches_;
   std::map<std::string,std::vector<bool>  > boolMaps_;
   std::map<std::string,std::vector<int>  > intMaps_;
   std::map<std::string,std::vector<double>  > doubleMaps_;
@@ -35,10 +49,16 @@ private :
   std::map<std::string,std::vector<std::vector<int>>> intVectorMaps_;
 
 public :
-  treeWriter(const char *treeName = "treeOut");
+  treeWriter(const char *treeName = "treeOut", bool withTree = true);
   TTree *getTree() const;
   void setTreeName(const char *c);
   void fillTree();
+  void clear();
+  void takeEvent(treeWriter &buffer);
+  bool openFile(const std::string &name, bool resume = false);
+  long long getResumeEvents() const;
+  void checkpoint();
+  void closeFile();
   void addCollection(std::string name, const jetCollection &c, bool writeConst = false);
   void addCollection(std::string name, const std::vector<fastjet::PseudoJet> &v, bool writeConst = false);
   void addCollection(std::string name, const std::vector<double> &v);
@@ -58,12 +78,15 @@ public :
   void bookBranchDoubleVectorVec(std::string name);
   void bookBranchIntVectorVec(std::string name);
 
+private :
+  template <class T> void bookBranch(std::string name, T *object);
 };
 
-treeWriter::treeWriter(const char *treeName)
-  : treeName_(treeName)
+treeWriter::treeWriter(const char *treeName, bool withTree)
+  : treeOut_(0), treeName_(treeName), file_(0), resumed_(false)
 {
-  treeOut_ = new TTree(treeName_,"JetToyHI tree");
+  if(withTree)
+    treeOut_ = new TTree(treeName_,"JetToyHI tree");
 }
 
 TTree *treeWriter::getTree() const
@@ -74,12 +97,120 @@ TTree *treeWriter::getTree() const
 void treeWriter::setTreeName(const char *c)
 {
   treeName_ = c;
-  treeOut_->SetName(c);
+  if(treeOut_)
+    treeOut_->SetName(c);
 }
 
 void treeWriter::fillTree()
 {
-  treeOut_->Fill();
+  if(treeOut_)
+    treeOut_->Fill();
+}
+
+void treeWriter::clear()
+{
+  boolMaps_.clear();
+  intMaps_.clear();
+  doubleMaps_.clear();
+  doubleVectorMaps_.clear();
+  intVectorMaps_.clear();
+}
+
+void treeWriter::takeEvent(treeWriter &buffer)
+{
+  //move the values collected by the buffer into the branches of this tree;
+  //branches the buffer did not set keep their previous values, exactly as
+  //if the event had been written here directly
+  for(auto &entry : buffer.boolMaps_) {
+    boolMaps_[entry.first].swap(entry.second);
+    bookBranchBoolVec(entry.first);
+  }
+  for(auto &entry : buffer.intMaps_) {
+    intMaps_[entry.first].swap(entry.second);
+    bookBranchIntVec(entry.first);
+  }
+  for(auto &entry : buffer.doubleMaps_) {
+    doubleMaps_[entry.first].swap(entry.second);
+    bookBranchDoubleVec(entry.first);
+  }
+  for(auto &entry : buffer.doubleVectorMaps_) {
+    doubleVectorMaps_[entry.first].swap(entry.second);
+    bookBranchDoubleVectorVec(entry.first);
+  }
+  for(auto &entry : buffer.intVectorMaps_) {
+    intVectorMaps_[entry.first].swap(entry.second);
+    bookBranchIntVectorVec(entry.first);
+  }
+  buffer.clear();
+}
+
+bool treeWriter::openFile(const std::string &name, bool resume)
+{
+  if(!treeOut_)
+    return false;
+
+  file_ = new TFile(name.c_str(), resume ? "UPDATE" : "RECREATE");
+  if(file_->IsZombie()) {
+    std::cerr << "ERROR: cannot open " << name << std::endl;
+    delete file_;
+    file_ = 0;
+    return false;
+  }
+
+  if(resume) {
+    TTree *previous = dynamic_cast<TTree*>(file_->Get(treeName_));
+    TParameter<Long64_t> *done = dynamic_cast<TParameter<Long64_t>*>(file_->Get("checkpoint"));
+    if(previous && done) {
+      if(done->GetVal() != previous->GetEntries())
+        std::cout << "WARNING: checkpoint of " << done->GetVal() << " events, but "
+                  << previous->GetEntries() << " in the tree of " << name << std::endl;
+      delete treeOut_;
+      treeOut_ = previous;
+      resumed_ = true;
+      std::cout << "Resuming after the " << treeOut_->GetEntries() << " events in " << name << std::endl;
+      return true;
+    }
+    std::cout << "No checkpoint in " << name << ", starting from the first event" << std::endl;
+    file_->Close();
+    delete file_;
+    file_ = new TFile(name.c_str(), "RECREATE");
+  }
+
+  treeOut_->SetDirectory(file_);
+  return true;
+}
+
+long long treeWriter::getResumeEvents() const
+{
+  return resumed_ ? treeOut_->GetEntries() : 0;
+}
+
+void treeWriter::checkpoint()
+{
+  if(!file_)
+    return;
+
+  //the event count goes first, so the tree header saved after it (which
+  //also saves the directory of the file) always matches it
+  TDirectory::TContext context(file_);
+  TParameter<Long64_t> done("checkpoint", treeOut_->GetEntries());
+  done.Write("checkpoint", TObject::kOverwrite);
+  treeOut_->AutoSave("SaveSelf;Overwrite");
+}
+
+void treeWriter::closeFile()
+{
+  if(!file_)
+    return;
+
+  TDirectory::TContext context(file_);
+  TParameter<Long64_t> done("checkpoint", treeOut_->GetEntries());
+  done.Write("checkpoint", TObject::kOverwrite);
+  treeOut_->Write("", TObject::kOverwrite);
+  file_->Close();
+  delete file_;
+  file_ = 0;
+  treeOut_ = 0;
 }
 
 void treeWriter::addCollection(std::string name, const jetCollection &c, bool writeConst)
@@ -190,23 +321,19 @@ void treeWriter::addJetCollection(std::string name, const std::vector<fastjet::P
     //addDoubleVectorCollection(name + "ConstPt", constPt);
     std::string branchName = name + "ConstPt";
     doubleVectorMaps_[branchName] = constPt;
-    if(!treeOut_->GetBranch(branchName.c_str()))
-      treeOut_->Branch(branchName.c_str(),&doubleVectorMaps_[branchName]);
+    bookBranchDoubleVectorVec(branchName);
     
     branchName = name + "ConstEta";
     doubleVectorMaps_[branchName] = constEta;
-    if(!treeOut_->GetBranch(branchName.c_str()))
-      treeOut_->Branch(branchName.c_str(),&doubleVectorMaps_[branchName]);
+    bookBranchDoubleVectorVec(branchName);
     
     branchName = name + "ConstPhi";
     doubleVectorMaps_[branchName] = constPhi;
-    if(!treeOut_->GetBranch(branchName.c_str()))
-      treeOut_->Branch(branchName.c_str(),&doubleVectorMaps_[branchName]);
+    bookBranchDoubleVectorVec(branchName);
 
     branchName = name + "ConstM";
     doubleVectorMaps_[branchName] = constM;
-    if(!treeOut_->GetBranch(branchName.c_str()))
-      treeOut_->Branch(branchName.c_str(),&doubleVectorMaps_[branchName]);
+    bookBranchDoubleVectorVec(branchName);
     
   }
 }
@@ -229,22 +356,45 @@ void treeWriter::addBoolCollection(std::string name, const std::vector<bool> v)
   bookBranchBoolVec(name);
 }
 
+template <class T>
+void treeWriter::bookBranch(std::string name, T *object)
+{
+  if(!treeOut_)
+    return;
+  if(!treeOut_->GetBranch(name.c_str())) {
+    TBranch *branch = treeOut_->Branch(name.c_str(), object);
+    //a branch first set after some events were filled (a stage of
+    //-timingtree that an early event did not run, say) gets an empty
+    //entry for each of them, so its entries stay those of the tree
+    Long64_t nFilled = treeOut_->GetEntries();
+    if(branch && nFilled > 0) {
+      T value;
+      value.swap(*object);
+      for(Long64_t i = 0; i < nFilled; i++)
+        branch->Fill();
+      value.swap(*object);
+    }
+  }
+  else if(resumed_ && resumedBranches_.count(name) == 0) {
+    //a branch of the tree picked up by openFile(): fill it from object
+    resumedBranches_[name] = object;
+    treeOut_->SetBranchAddress(name.c_str(), (void *)&resumedBranches_[name]);
+  }
+}
+
 void treeWriter::bookBranchDoubleVec(std::string name)
 {
-  if(!treeOut_->GetBranch(name.c_str()))
-    treeOut_->Branch(name.c_str(),&doubleMaps_[name]);
+  bookBranch(name, &doubleMaps_[name]);
 }
 
 void treeWriter::bookBranchIntVec(std::string name)
 {
-  if(!treeOut_->GetBranch(name.c_str()))
-    treeOut_->Branch(name.c_str(),&intMaps_[name]);
+  bookBranch(name, &intMaps_[name]);
 }
 
 void treeWriter::bookBranchBoolVec(std::string name)
 {
-  if(!treeOut_->GetBranch(name.c_str()))
-    treeOut_->Branch(name.c_str(),&boolMaps_[name]);
+  bookBranch(name, &boolMaps_[name]);
 }
 
 
@@ -263,14 +413,12 @@ void treeWriter::addIntVectorCollection(std::string name, const std::vector<std:
 
 void treeWriter::bookBranchDoubleVectorVec(std::string name)
 {
-  if(!treeOut_->GetBranch(name.c_str()))
-    treeOut_->Branch(name.c_str(), &doubleVectorMaps_[name]);
+  bookBranch(name, &doubleVectorMaps_[name]);
 }
 
 void treeWriter::bookBranchIntVectorVec(std::string name)
 {
-  if(!treeOut_->GetBranch(name.c_str()))
-    treeOut_->Branch(name.c_str(), &intVectorMaps_[name]);
+  bookBranch(name, &intVectorMaps_[name]);
 }
 
 
@@ -0,0 +1,339 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequenceArea.hh"
+
+#include "PU14/EventSource.hh"
+#include "PU14/EventMixer.hh"
+#include "PU14/CmdLine.hh"
+#include "PU14/PU14.hh"
+
+#include "include/thermalEvent.hh"
+#include "include/jetCollection.hh"
+#include "include/csSubtractor.hh"
+#include "include/skSubtractor.hh"
+#include "include/sharedLayerSubtractor.hh"
+#include "include/softDropGroomer.hh"
+#include "include/softDropCounter.hh"
+#include "include/jetMatcher.hh"
+#include "include/jewelMatcher.hh"
+#include "include/Angularity.hh"
+#include "include/treeWriter.hh"
+#include "include/randomStream.hh"
+
+using namespace std;
+using namespace fastjet;
+
+// Times each component of include/ (and the PU14 reading and mixing) on its
+// own, on the same prepared inputs, so that a change in one of them shows up
+// as a change in its own line.
+//
+// The inputs are the first -nev events of the sample file, each embedded in a
+// thermal background of -mult particles (thermalEvent, |y| < 3).  A fraction
+// -dummy of the thermal particles also gets a JEWEL-like dummy (vertex -1,
+// negligible momentum, same direction) so that the jewelMatcher functions have
+// something to find.  Jet-level components run on the anti-kt R = 0.4 jets
+// with pt > 20 GeV of the embedded events; jetMatcher matches them to the jets
+// of the sample event alone.
+//
+// For every component the program prints events/s and ns per input particle
+// (particles of the event, or constituents of the jets for the jet-level
+// components) and writes the same numbers to the -json file.
+//
+// ./runBenchmarkComponents -input samples/PythiaEventsTune14PtHat120.pu14 -nev 20 -mult 7000 -json BenchmarkComponents.json
+
+struct ComponentResult
+{
+   string Name;
+   double Seconds;
+   long long EventCount;
+   long long ParticleCount;
+};
+
+template <class Function>
+ComponentResult TimeComponent(const string &Name, int EventCount, int Repeat, Function F);
+void PrintResult(const ComponentResult &Result);
+bool WriteJSON(const string &FileName, const string &InputFileName, int EventCount, int Multiplicity,
+   const vector<ComponentResult> &Results);
+long long CountConstituents(const vector<PseudoJet> &Jets);
+
+int main(int argc, char *argv[])
+{
+   CmdLine cmdline(argc, argv);
+
+   string InputFileName = cmdline.value<string>("-input", "samples/PythiaEventsTune14PtHat120.pu14");
+   string JSONFileName  = cmdline.value<string>("-json", "BenchmarkComponents.json");
+   int EventCount       = cmdline.value<int>("-nev", 20);
+   int Multiplicity     = cmdline.value<int>("-mult", 7000);
+   double DummyFraction = cmdline.value<double>("-dummy", 0.1);
+   int PileupCount      = cmdline.value<int>("-npu", 20);
+   int Repeat           = cmdline.value<int>("-repeat", 1);
+   int Seed             = cmdline.value<int>("-seed", 1);
+
+   ClusterSequence::set_fastjet_banner_stream(NULL);
+   randomService::setSeed(Seed);
+
+   double R = 0.4;
+   double JetRapMax = 3.0;
+   double GhostRapMax = JetRapMax + R;
+   double GhostArea = 0.005;
+   GhostedAreaSpec GhostSpec(GhostRapMax, 1, GhostArea);
+   AreaDefinition AreaDef(active_area, GhostSpec);
+   JetDefinition JetDef(antikt_algorithm, R);
+   Selector JetSelector = SelectorAbsRapMax(JetRapMax) * SelectorPtMin(20.);
+
+   //---------------------------------------------------------------------------
+   //   prepare the inputs
+   //---------------------------------------------------------------------------
+
+   vector<vector<PseudoJet>> Hard, Embedded, Dummies;
+
+   EventSource Source(InputFileName, "PU14");
+   vector<PseudoJet> Particles;
+   double Weight;
+   while((int)Hard.size() < EventCount && Source.append_next_event(Particles, Weight))
+   {
+      Hard.push_back(Particles);
+      Particles.clear();
+   }
+   if(Hard.size() == 0)
+   {
+      cerr << "ERROR: no events read from " << InputFileName << endl;
+      return -1;
+   }
+   EventCount = Hard.size();
+
+   thermalEvent Thermal(Multiplicity, 0.7, -JetRapMax, JetRapMax);
+   for(int iE = 0; iE < EventCount; iE++)
+   {
+      randomService::beginEvent(iE);
+      vector<PseudoJet> Background = Thermal.createThermalEvent();
+      randomStream Random = randomService::stream("Dummies");
+      vector<PseudoJet> Event = Hard[iE];
+      vector<PseudoJet> EventDummies;
+      for(int i = 0; i < (int)Background.size(); i++)
+      {
+         Event.push_back(Background[i]);
+         if(Random.uniform() < DummyFraction)
+         {
+            PseudoJet Dummy = Background[i] * 1e-6;
+            set_pu14_info(Dummy, 22, -1);
+            Event.push_back(Dummy);
+            EventDummies.push_back(Dummy);
+         }
+      }
+      Embedded.push_back(Event);
+      Dummies.push_back(EventDummies);
+   }
+
+   //the jets the jet-level components run on, with their cluster sequences
+   vector<unique_ptr<ClusterSequenceArea>> EmbeddedClusters, HardClusters;
+   vector<vector<PseudoJet>> EmbeddedJets, HardJets;
+   vector<long long> ConstituentCount;
+   long long JetCount = 0;
+   for(int iE = 0; iE < EventCount; iE++)
+   {
+      EmbeddedClusters.push_back(unique_ptr<ClusterSequenceArea>(new ClusterSequenceArea(Embedded[iE], JetDef, AreaDef)));
+      EmbeddedJets.push_back(sorted_by_pt(JetSelector(EmbeddedClusters[iE]->inclusive_jets())));
+      HardClusters.push_back(unique_ptr<ClusterSequenceArea>(new ClusterSequenceArea(Hard[iE], JetDef, AreaDef)));
+      HardJets.push_back(sorted_by_pt(JetSelector(HardClusters[iE]->inclusive_jets())));
+      ConstituentCount.push_back(CountConstituents(EmbeddedJets[iE]));
+      JetCount = JetCount + EmbeddedJets[iE].size();
+   }
+
+   cout << EventCount << " events embedded in " << Multiplicity << " thermal particles, "
+      << JetCount << " jets, " << Repeat << " passes" << endl;
+   cout << endl;
+   cout << setw(24) << "component" << setw(12) << "events/s" << setw(14) << "ns/particle" << endl;
+
+   //---------------------------------------------------------------------------
+   //   time the components
+   //---------------------------------------------------------------------------
+
+   vector<ComponentResult> Results;
+
+   Results.push_back(TimeComponent("PU14 parsing", 1, Repeat, [&](int)
+   {
+      EventSource ParsingSource(InputFileName, "PU14");
+      vector<PseudoJet> ParsingParticles;
+      double ParsingWeight;
+      long long ParticleCount = 0;
+      for(int iE = 0; iE < EventCount && ParsingSource.append_next_event(ParsingParticles, ParsingWeight); iE++)
+      {
+         ParticleCount = ParticleCount + ParsingParticles.size();
+         ParsingParticles.clear();
+      }
+      return ParticleCount;
+   }));
+   Results.back().EventCount = (long long)EventCount * Repeat;
+
+   vector<string> MixerArguments = {"runBenchmarkComponents", "-hard", InputFileName,
+      "-pileup", InputFileName, "-npu", to_string(PileupCount)};
+   CmdLine MixerCmdLine(MixerArguments);
+   EventMixer Mixer(&MixerCmdLine);
+   Results.push_back(TimeComponent("EventMixer", EventCount, Repeat, [&](int)
+   {
+      if(Mixer.next_event() == false)
+         return (long long)0;
+      return (long long)Mixer.particles().size();
+   }));
+
+   Results.push_back(TimeComponent("area clustering", EventCount, Repeat, [&](int iE)
+   {
+      ClusterSequenceArea Cluster(Embedded[iE], JetDef, AreaDef);
+      vector<PseudoJet> Jets = JetSelector(Cluster.inclusive_jets());
+      return (long long)Embedded[iE].size();
+   }));
+
+   Results.push_back(TimeComponent("csSubtractor", EventCount, Repeat, [&](int iE)
+   {
+      csSubtractor Subtractor(R, 0., -1, GhostArea, GhostRapMax, JetRapMax);
+      Subtractor.setInputParticles(Embedded[iE]);
+      vector<PseudoJet> Jets = Subtractor.doSubtraction();
+      return (long long)Embedded[iE].size();
+   }));
+
+   Results.push_back(TimeComponent("skSubtractor", EventCount, Repeat, [&](int iE)
+   {
+      skSubtractor Subtractor(R, JetRapMax);
+      Subtractor.setInputParticles(Embedded[iE]);
+      vector<PseudoJet> Event = Subtractor.doSubtraction();
+      return (long long)Embedded[iE].size();
+   }));
+
+   Results.push_back(TimeComponent("sharedLayerSubtractor", EventCount, Repeat, [&](int iE)
+   {
+      sharedLayerSubtractor Subtractor(R, GhostArea, GhostRapMax, JetRapMax);
+      Subtractor.setInputParticles(Embedded[iE]);
+      vector<PseudoJet> Jets = Subtractor.doSubtraction();
+      return (long long)Embedded[iE].size();
+   }));
+
+   Results.push_back(TimeComponent("softDropGroomer", EventCount, Repeat, [&](int iE)
+   {
+      softDropGroomer Groomer(0.1, 0., R);
+      vector<PseudoJet> Groomed = Groomer.doGrooming(EmbeddedJets[iE]);
+      return ConstituentCount[iE];
+   }));
+
+   Results.push_back(TimeComponent("softDropCounter", EventCount, Repeat, [&](int iE)
+   {
+      softDropCounter Counter(0.1, 0., R, 0.1);
+      Counter.run(EmbeddedJets[iE]);
+      return ConstituentCount[iE];
+   }));
+
+   Results.push_back(TimeComponent("jetMatcher", EventCount, Repeat, [&](int iE)
+   {
+      jetMatcher Matcher(R);
+      Matcher.setBaseJets(EmbeddedJets[iE]);
+      Matcher.setTagJets(HardJets[iE]);
+      Matcher.matchJets();
+      return ConstituentCount[iE];
+   }));
+
+   Results.push_back(TimeComponent("jewelMatcher", EventCount, Repeat, [&](int iE)
+   {
+      vector<PseudoJet> Corrected = GetCorrectedJets(EmbeddedJets[iE], Dummies[iE]);
+      return ConstituentCount[iE];
+   }));
+
+   Angularity Width(1., 1., R);
+   vector<double> Widths;
+   Results.push_back(TimeComponent("Angularity", EventCount, Repeat, [&](int iE)
+   {
+      for(const PseudoJet &Jet : EmbeddedJets[iE])
+         Widths.push_back(Width.result(Jet));
+      return ConstituentCount[iE];
+   }));
+
+   treeWriter Writer("BenchmarkTree");
+   Results.push_back(TimeComponent("treeWriter", EventCount, Repeat, [&](int iE)
+   {
+      Writer.addCollection("Jet", EmbeddedJets[iE], true);
+      Writer.addCollection("SignalJet", HardJets[iE]);
+      Writer.fillTree();
+      return ConstituentCount[iE];
+   }));
+
+   for(int i = 0; i < (int)Results.size(); i++)
+      PrintResult(Results[i]);
+
+   if(JSONFileName != "" && WriteJSON(JSONFileName, InputFileName, EventCount, Multiplicity, Results) == false)
+   {
+      cerr << "ERROR: cannot write " << JSONFileName << endl;
+      return -1;
+   }
+
+   return 0;
+}
+
+template <class Function>
+ComponentResult TimeComponent(const string &Name, int EventCount, int Repeat, Function F)
+{
+   ComponentResult Result;
+   Result.Name = Name;
+   Result.EventCount = (long long)EventCount * Repeat;
+   Result.ParticleCount = 0;
+
+   auto start_time = chrono::steady_clock::now();
+   for(int i = 0; i < Repeat; i++)
+      for(int iE = 0; iE < EventCount; iE++)
+         Result.ParticleCount = Result.ParticleCount + F(iE);
+   Result.Seconds = chrono::duration_cast<chrono::nanoseconds>
+      (chrono::steady_clock::now() - start_time).count() / 1e9;
+
+   return Result;
+}
+
+void PrintResult(const ComponentResult &Result)
+{
+   cout << setw(24) << Result.Name
+        << setw(12) << fixed << setprecision(1) << Result.EventCount / Result.Seconds
+        << setw(14) << setprecision(2) << Result.Seconds * 1e9 / max(Result.ParticleCount, 1LL) << endl;
+   cout.unsetf(ios::fixed);
+   cout << setprecision(6);
+}
+
+bool WriteJSON(const string &FileName, const string &InputFileName, int EventCount, int Multiplicity,
+   const vector<ComponentResult> &Results)
+{
+   ofstream out(FileName.c_str());
+   if(!out)
+      return false;
+
+   out << "{" << endl;
+   out << "  \"input\": \"" << InputFileName << "\"," << endl;
+   out << "  \"events\": " << EventCount << "," << endl;
+   out << "  \"thermal_multiplicity\": " << Multiplicity << "," << endl;
+   out << "  \"components\": [" << endl;
+   for(int i = 0; i < (int)Results.size(); i++)
+   {
+      const ComponentResult &Result = Results[i];
+      out << "    {\"name\": \"" << Result.Name << "\""
+          << ", \"seconds\": " << Result.Seconds
+          << ", \"events\": " << Result.EventCount
+          << ", \"particles\": " << Result.ParticleCount
+          << ", \"events_per_second\": " << Result.EventCount / Result.Seconds
+          << ", \"ns_per_particle\": " << Result.Seconds * 1e9 / max(Result.ParticleCount, 1LL)
+          << "}" << (i + 1 < (int)Results.size() ? "," : "") << endl;
+   }
+   out << "  ]" << endl;
+   out << "}" << endl;
+
+   return true;
+}
+
+long long CountConstituents(const vector<PseudoJet> &Jets)
+{
+   long long Count = 0;
+   for(const PseudoJet &Jet : Jets)
+      Count = Count + Jet.constituents().size();
+   return Count;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "fastjet/PseudoJet.hh"
+
+#include "PU14/EventSource.hh"
+#include "PU14/CmdLine.hh"
+#include "PU14/PU14.hh"
+#include "PU14/HepPID/ParticleIDMethods.hh"
+
+using namespace std;
+using namespace fastjet;
+
+// Measures the per-call cost of HepPID::threeCharge and HepPID::isHadron,
+// which look up the common PDG ids in a table, against the digit-decoding
+// versions they fall back to for other ids (threeChargeFromDigits and
+// isHadronFromDigits).  The ids are those of the particles in the input
+// file, in file order, so the mix is the one the run programs see.
+//
+// Before timing, the program checks that the two versions agree for all ids
+// with |pid| <= 20000 and for every id in the file.
+//
+// ./runBenchmarkPDG -input samples/PythiaEventsTune14PtHat120.pu14 -repeat 20
+
+struct CallResult
+{
+   double Seconds;
+   long long Sum;
+};
+
+template <class Function>
+CallResult TimeCalls(const vector<int> &IDs, int Repeat, Function F);
+void PrintResult(const string &Name, const CallResult &Result, long long CallCount, double Reference);
+
+int main(int argc, char *argv[])
+{
+   CmdLine cmdline(argc, argv);
+
+   string InputFileName = cmdline.value<string>("-input", "samples/PythiaEventsTune14PtHat120.pu14");
+   string Type          = cmdline.value<string>("-type", "PU14");
+   int Repeat           = cmdline.value<int>("-repeat", 20);
+
+   vector<int> IDs;
+   vector<PseudoJet> Particles;
+   double Weight;
+
+   EventSource Source(InputFileName, Type);
+   while(Source.append_next_event(Particles, Weight))
+   {
+      for(int i = 0; i < (int)Particles.size(); i++)
+         IDs.push_back(pu14_info(Particles[i]).pdg_id());
+      Particles.clear();
+   }
+   if(IDs.size() == 0)
+   {
+      cerr << "ERROR: no particles read from " << InputFileName << endl;
+      return -1;
+   }
+
+   vector<int> CheckIDs = IDs;
+   for(int ID = -20000; ID <= 20000; ID++)
+      CheckIDs.push_back(ID);
+   for(int i = 0; i < (int)CheckIDs.size(); i++)
+   {
+      int ID = CheckIDs[i];
+      if(HepPID::threeCharge(ID) != HepPID::threeChargeFromDigits(ID)
+         || HepPID::isHadron(ID) != HepPID::isHadronFromDigits(ID))
+      {
+         cerr << "ERROR: table and digit decoding disagree for id " << ID << endl;
+         return -1;
+      }
+   }
+
+   long long CallCount = (long long)IDs.size() * Repeat;
+   cout << IDs.size() << " particle ids, " << Repeat << " passes" << endl;
+   cout << endl;
+   cout << setw(24) << "function" << setw(12) << "ns/call" << setw(10) << "speed-up" << endl;
+
+   CallResult ChargeDigits = TimeCalls(IDs, Repeat, [](int ID) {return HepPID::threeChargeFromDigits(ID);});
+   CallResult Charge       = TimeCalls(IDs, Repeat, [](int ID) {return HepPID::threeCharge(ID);});
+   CallResult HadronDigits = TimeCalls(IDs, Repeat, [](int ID) {return (int)HepPID::isHadronFromDigits(ID);});
+   CallResult Hadron       = TimeCalls(IDs, Repeat, [](int ID) {return (int)HepPID::isHadron(ID);});
+
+   PrintResult("threeChargeFromDigits", ChargeDigits, CallCount, ChargeDigits.Seconds);
+   PrintResult("threeCharge", Charge, CallCount, ChargeDigits.Seconds);
+   PrintResult("isHadronFromDigits", HadronDigits, CallCount, HadronDigits.Seconds);
+   PrintResult("isHadron", Hadron, CallCount, HadronDigits.Seconds);
+
+   if(ChargeDigits.Sum != Charge.Sum || HadronDigits.Sum != Hadron.Sum)
+   {
+      cerr << "ERROR: table and digit decoding disagree" << endl;
+      return -1;
+   }
+
+   return 0;
+}
+
+template <class Function>
+CallResult TimeCalls(const vector<int> &IDs, int Repeat, Function F)
+{
+   CallResult Result;
+   Result.Sum = 0;
+
+   auto start_time = chrono::steady_clock::now();
+   for(int i = 0; i < Repeat; i++)
+      for(int j = 0; j < (int)IDs.size(); j++)
+         Result.Sum = Result.Sum + F(IDs[j]);
+   Result.Seconds = chrono::duration_cast<chrono::nanoseconds>
+      (chrono::steady_clock::now() - start_time).count() / 1e9;
+
+   return Result;
+}
+
+void PrintResult(const string &Name, const CallResult &Result, long long CallCount, double Reference)
+{
+   cout << setw(24) << Name
+        << setw(12) << fixed << setprecision(2) << Result.Seconds * 1e9 / CallCount
+        << setw(10) << setprecision(2) << Reference / Result.Seconds << endl;
+   cout.unsetf(ios::fixed);
+   cout << setprecision(6);
+}
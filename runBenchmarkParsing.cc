@@ -0,0 +1,157 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <new>
+
+#include <sys/stat.h>
+
+#include "fastjet/PseudoJet.hh"
+
+#include "PU14/EventSource.hh"
+#include "PU14/CmdLine.hh"
+
+using namespace std;
+using namespace fastjet;
+
+// Measures the input throughput of the different EventSource readers on the
+// same file: the original istream parser (PU14Stream), the zero-copy text
+// parser (PU14) and, if a converted file is given, the binary reader.
+//
+// Target: the PU14 text reader should reach at least 2 times the events/s of
+// PU14Stream on samples/PythiaEventsTune14PtHat120.pu14; the program reports
+// whether this is met.  The binary reader does no parsing at all, so its
+// ns/particle is the cost of building the PseudoJets and their user info,
+// i.e. the floor that any text reader sits on.
+//
+// The allocs/event column counts heap allocations (operator new) per event.
+// PU14Stream still gives each particle a heap-allocated PU14 user info; the
+// other readers use the compact PU14 information (see set_pu14_info).
+//
+// ./runBenchmarkParsing -input samples/PythiaEventsTune14PtHat120.pu14 -repeat 50 [-binary sample.pu14bin]
+
+// counts every allocation made through operator new
+static long long AllocationCount = 0;
+
+void *operator new(size_t Size)
+{
+   AllocationCount = AllocationCount + 1;
+   void *Pointer = malloc(Size > 0 ? Size : 1);
+   if(Pointer == NULL)
+      throw bad_alloc();
+   return Pointer;
+}
+
+void operator delete(void *Pointer) noexcept
+{
+   free(Pointer);
+}
+
+void operator delete(void *Pointer, size_t) noexcept
+{
+   free(Pointer);
+}
+
+struct ParsingResult
+{
+   double Seconds;
+   double Bytes;
+   long long EventCount;
+   long long ParticleCount;
+   long long AllocationCount;
+};
+
+ParsingResult RunParsing(const string &FileName, const string &Type, int Repeat);
+void PrintResult(const string &Type, const ParsingResult &Result, const ParsingResult &Reference);
+
+int main(int argc, char *argv[])
+{
+   CmdLine cmdline(argc, argv);
+
+   string InputFileName  = cmdline.value<string>("-input", "samples/PythiaEventsTune14PtHat120.pu14");
+   string BinaryFileName = cmdline.value<string>("-binary", "");
+   int Repeat            = cmdline.value<int>("-repeat", 20);
+   double Target         = cmdline.value<double>("-target", 2.0);
+
+   cout << "Reading " << InputFileName << " " << Repeat << " times per reader" << endl;
+   cout << endl;
+   cout << setw(12) << "reader" << setw(12) << "MB/s" << setw(14) << "events/s"
+        << setw(14) << "ns/particle" << setw(14) << "allocs/event" << setw(10) << "speed-up" << endl;
+
+   ParsingResult Stream = RunParsing(InputFileName, "PU14Stream", Repeat);
+   PrintResult("PU14Stream", Stream, Stream);
+
+   ParsingResult Text = RunParsing(InputFileName, "PU14", Repeat);
+   PrintResult("PU14", Text, Stream);
+
+   if(BinaryFileName != "")
+   {
+      ParsingResult Binary = RunParsing(BinaryFileName, "PU14Binary", Repeat);
+      PrintResult("PU14Binary", Binary, Stream);
+   }
+
+   if(Text.EventCount != Stream.EventCount || Text.ParticleCount != Stream.ParticleCount)
+   {
+      cerr << "ERROR: PU14 and PU14Stream readers disagree on the content of the file" << endl;
+      return -1;
+   }
+
+   double SpeedUp = (Text.EventCount / Text.Seconds) / (Stream.EventCount / Stream.Seconds);
+   cout << endl;
+   cout << "PU14 reader speed-up " << SpeedUp << " (target " << Target << "): "
+        << ((SpeedUp >= Target) ? "met" : "NOT met") << endl;
+
+   return 0;
+}
+
+ParsingResult RunParsing(const string &FileName, const string &Type, int Repeat)
+{
+   ParsingResult Result;
+   Result.Seconds = 0;
+   Result.Bytes = 0;
+   Result.EventCount = 0;
+   Result.ParticleCount = 0;
+   Result.AllocationCount = 0;
+
+   struct stat Info;
+   if(stat(FileName.c_str(), &Info) == 0)
+      Result.Bytes = (double)Info.st_size * Repeat;
+
+   vector<PseudoJet> Particles;
+   double Weight;
+
+   long long StartAllocationCount = AllocationCount;
+   auto start_time = chrono::steady_clock::now();
+   for(int i = 0; i < Repeat; i++)
+   {
+      EventSource Source(FileName, Type);
+      while(Source.append_next_event(Particles, Weight))
+      {
+         Result.EventCount = Result.EventCount + 1;
+         Result.ParticleCount = Result.ParticleCount + Particles.size();
+         Particles.clear();
+      }
+   }
+   Result.Seconds = chrono::duration_cast<chrono::microseconds>
+      (chrono::steady_clock::now() - start_time).count() / 1e6;
+   Result.AllocationCount = AllocationCount - StartAllocationCount;
+
+   return Result;
+}
+
+void PrintResult(const string &Type, const ParsingResult &Result, const ParsingResult &Reference)
+{
+   double EventRate = Result.EventCount / Result.Seconds;
+   double ReferenceRate = Reference.EventCount / Reference.Seconds;
+
+   cout << setw(12) << Type
+        << setw(12) << fixed << setprecision(1) << Result.Bytes / 1e6 / Result.Seconds
+        << setw(14) << setprecision(0) << EventRate
+        << setw(14) << setprecision(1) << Result.Seconds * 1e9 / Result.ParticleCount
+        << setw(14) << setprecision(1) << (double)Result.AllocationCount / Result.EventCount
+        << setw(10) << setprecision(2) << EventRate / ReferenceRate << endl;
+   cout.unsetf(ios::fixed);
+   cout << setprecision(6);
+}
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <chrono>
+
+#include "PU14/EventIndex.hh"
+#include "PU14/CmdLine.hh"
+
+using namespace std;
+
+// Builds the side-car event index (<input>.idx) of an event file, which
+// EventSource uses to jump to an event number (-skip, -shard).  Jobs build
+// it on first use anyway; running this once before submitting many jobs on
+// the same file saves each of them from doing it.
+//
+// ./runBuildIndex -input jewel.pu14.gz [-type PU14]
+
+int main(int argc, char *argv[])
+{
+   auto start_time = chrono::steady_clock::now();
+
+   CmdLine cmdline(argc, argv);
+
+   string InputFileName = cmdline.value<string>("-input");
+   string InputType     = cmdline.value<string>("-type", "PU14");
+   string IndexFileName = cmdline.value<string>("-output", EventIndex::default_name(InputFileName));
+
+   EventIndex Index;
+   if(Index.build(InputFileName, InputType) == false)
+   {
+      cerr << "ERROR: could not index " << InputFileName << endl;
+      return -1;
+   }
+   if(Index.save(IndexFileName) == false)
+   {
+      cerr << "ERROR: could not write " << IndexFileName << endl;
+      return -1;
+   }
+
+   double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
+      (chrono::steady_clock::now() - start_time).count() / 1000.0;
+   cout << "Indexed " << Index.event_count() << " events ("
+        << Index.restart_points().size() << " restart points) in "
+        << time_in_seconds << " seconds" << endl;
+
+   return 0;
+}
@@ -7,8 +7,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -16,9 +14,12 @@
 #include "include/jetCollection.hh"
 #include "include/csSubtractor.hh"
 #include "include/csSubtractorFullEvent.hh"
+#include "include/eventBackground.hh"
+#include "include/ghostSet.hh"
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
@@ -44,9 +45,11 @@ int main (int argc, char ** argv) {
 
   //to write info to root tree
   treeWriter trw("jetTree");
+  trw.openFile("JetToyHIResultCSVariations.root", cmdline.present("-resume"));
 
   //Jet definition
   double R                   = 0.4;
+  double jetRapMax           = 3.0;
   double ghostRapMax         = 6.0;
   double ghost_area          = 0.005;
   int    active_area_repeats = 1;
@@ -54,33 +57,26 @@ int main (int argc, char ** argv) {
   fastjet::AreaDefinition area_def = fastjet::AreaDefinition(fastjet::active_area,ghost_spec);
   fastjet::JetDefinition jet_def(antikt_algorithm, R);
 
-  double jetRapMax = 3.0;
   fastjet::Selector jet_selector = SelectorAbsRapMax(jetRapMax);
 
   Angularity width(1.,1.,R);
   Angularity pTD(0.,2.,R);
     
-  ProgressBar Bar(cout, nEvent);
-  Bar.SetStyle(-1);
 
-  EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+  randomService::setSeed(cmdline.value<int>("-seed", 1));
+  EventMixer mixer(&cmdline, trw.getResumeEvents());  //the mixing machinery from PU14 workshop
+  stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
   // loop over events
-  int iev = 0;
-  unsigned int entryDiv = (nEvent > 200) ? nEvent / 200 : 1;
-  while ( mixer.next_event() && iev < nEvent )
+  eventLoop loop(mixer, nEvent, cmdline.value<int>("-nthreads", 1));
+  loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+  loop.run(trw, [&](const eventData &event, treeWriter &trw)
   {
-    // increment event number    
-    iev++;
-
-    Bar.Update(iev);
-    Bar.PrintWithMod(entryDiv);
-
-    std::vector<fastjet::PseudoJet> particlesMerged = mixer.particles();
+    std::vector<fastjet::PseudoJet> particlesMerged = event.particles;
 
     std::vector<double> eventWeight;
-    eventWeight.push_back(mixer.hard_weight());
-    eventWeight.push_back(mixer.pu_weight());
+    eventWeight.push_back(event.hardWeight);
+    eventWeight.push_back(event.puWeight);
 
     // cluster hard event only
     std::vector<fastjet::PseudoJet> particlesBkg, particlesSig;
@@ -91,7 +87,7 @@ int main (int argc, char ** argv) {
     //---------------------------------------------------------------------------
     
     // run the clustering, extract the signal jets
-    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, area_def);
+    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, ghostSet::seeded(area_def));
     jetCollection jetCollectionSig(sorted_by_pt(jet_selector(csSig.inclusive_jets(10.))));
 
     //---------------------------------------------------------------------------
@@ -104,9 +100,18 @@ int main (int argc, char ** argv) {
     std::vector<jetCollection> jetCollectionCSs;
     std::vector<double> rho;
     std::vector<double> rhom; 
+    //the jets and background densities do not depend on alpha: make them once
+    ghostSet ghosts(ghostRapMax, ghost_area);
+    fastjet::ClusterSequenceActiveAreaExplicitGhosts csMerged(particlesMerged, jet_def, ghosts.getGhosts(), ghosts.getGhostArea());
+    std::vector<fastjet::PseudoJet> jetsMerged = csMerged.inclusive_jets();
+    eventBackground background(ghostRapMax, 0.005, jetRapMax-0.4);
+    background.setGhosts(&ghosts);
+    background.setInputParticles(particlesMerged);
     for(int ics = 0; ics<ncs; ++ics) {
       csSubtractor csSub(R, alpha[ics], -1, 0.005,ghostRapMax,jetRapMax);
       csSub.setInputParticles(particlesMerged);
+      csSub.setInputJets(jetsMerged);
+      csSub.setBackground(&background);
       jetCollection jetCollectionCS(csSub.doSubtraction());
 
       if(ics==3) {
@@ -176,20 +181,10 @@ int main (int argc, char ** argv) {
 
     trw.addCollection("eventWeight",   eventWeight);
         
-    trw.fillTree();
-
-  }//event loop
-
-  Bar.Update(nEvent);
-  Bar.Print();
-  Bar.PrintLine();
 
-  TTree *trOut = trw.getTree();
+  });//event loop
 
-  TFile *fout = new TFile("JetToyHIResultCSVariations.root","RECREATE");
-  trOut->Write();
-  fout->Write();
-  fout->Close();
+  trw.closeFile();
 
   double time_in_seconds = std::chrono::duration_cast<std::chrono::milliseconds>
     (std::chrono::steady_clock::now() - start_time).count() / 1000.0;
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <chrono>
+
+#include "fastjet/PseudoJet.hh"
+
+#include "include/ProgressBar.h"
+
+#include "PU14/EventSource.hh"
+#include "PU14/EventBinary.hh"
+#include "PU14/CmdLine.hh"
+
+using namespace std;
+using namespace fastjet;
+
+// Converts a text event file (.pu14, .pu14.gz or HepMC) into the PU14Binary
+// format, which can then be read back with -hardtype/-pileuptype PU14Binary
+//
+// ./runConversionBinary -input samples/ThermalEventsMult12000PtAv0.70.pu14 -output ThermalEventsMult12000PtAv0.70.pu14bin
+
+int main(int argc, char *argv[])
+{
+   auto start_time = chrono::steady_clock::now();
+
+   CmdLine cmdline(argc, argv);
+
+   string InputFileName  = cmdline.value<string>("-input");
+   string OutputFileName = cmdline.value<string>("-output");
+   string InputType      = cmdline.value<string>("-type", "PU14");
+   int EventCount        = cmdline.value<int>("-nev", -1);   // -1 = whole file
+
+   EventSource Source(InputFileName, InputType);
+   BinaryEventWriter Writer(OutputFileName);
+   if(Writer.good() == false)
+   {
+      cerr << "ERROR: could not write to " << OutputFileName << endl;
+      return -1;
+   }
+
+   ProgressBar Bar(cout, EventCount > 0 ? EventCount : 1);
+   Bar.SetStyle(-1);
+
+   vector<PseudoJet> Particles;
+   double Weight = 1;
+   int iEvent = 0;
+   while((EventCount < 0 || iEvent < EventCount) && Source.append_next_event(Particles, Weight))
+   {
+      Writer.write_event(Particles, Weight);
+      Particles.clear();
+
+      iEvent = iEvent + 1;
+      if(EventCount > 0)
+      {
+         Bar.Update(iEvent);
+         Bar.PrintWithMod(EventCount > 200 ? EventCount / 200 : 1);
+      }
+   }
+
+   if(EventCount > 0)
+   {
+      Bar.Update(EventCount);
+      Bar.Print();
+      Bar.PrintLine();
+   }
+
+   if(Writer.good() == false)
+   {
+      cerr << "ERROR: failed while writing " << OutputFileName << endl;
+      return -1;
+   }
+
+   double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
+      (chrono::steady_clock::now() - start_time).count() / 1000.0;
+   cout << "Converted " << Writer.event_count() << " events in " << time_in_seconds << " seconds" << endl;
+
+   return 0;
+}
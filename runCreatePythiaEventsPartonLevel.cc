@@ -11,7 +11,7 @@
 #include "include/ProgressBar.h"
 
 #include "include/pythiaEvent.hh"
-#include "include/extraInfo.hh"
+#include "PU14/PU14.hh"
 
 #include "PU14/CmdLine.hh"
 
@@ -36,6 +36,7 @@ int main (int argc, char ** argv)
 
   std::cout << "generating " << nEvent << " events with pthat = " << ptHat << " and tune = " << tune << std::endl;  
 
+  randomService::setSeed(cmdline.value<int>("-seed",1));
   pythiaEvent pyt(ptHat, tune, -3.0, 3.0, true);
 
   ProgressBar Bar(cout, nEvent);
@@ -66,8 +67,8 @@ int main (int argc, char ** argv)
     std::vector<fastjet::PseudoJet> particlesSig = pyt.createPythiaEvent();
    
     for(fastjet::PseudoJet p : particlesSig) {
-      const int & pdgid = p.user_info<extraInfo>().pdg_id();
-      const int & vtx   = p.user_info<extraInfo>().vertex_number();
+      const int & pdgid = pu14_info(p).pdg_id();
+      const int & vtx   = pu14_info(p).vertex_number();
       fout << p.px() << " " << p.py() << " " << p.pz() << " " << p.m() << " " << pdgid << " " << vtx << "\n";
       //fout << p.pt() << " " << p.rap() << " " << p.phi() << " " << p.m() << " " << pdgid << " " << vtx << "\n"; 
     }
@@ -54,6 +54,7 @@ int main (int argc, char ** argv)
   ofstream fout;
   const char *dir = getenv("PWD");//"/eos/user/m/mverweij/JetWorkshop2017/samples/";
   int jobId = cmdline.value<int>("-jobId",0); 
+  randomService::setSeed(cmdline.value<int>("-seed",jobId+1)); //different events for every job
   TString outFileName = Form("%s/ThermalEventsMult%dPtAv%.2f_%d.pu14",dir,mult,ptAve,jobId);
   
   fout.open(outFileName.Data());
@@ -73,11 +74,12 @@ int main (int argc, char ** argv)
     fout << "# event " << ie << "\n";
     
     //create thermal event
+    randomService::beginEvent(ie);
     std::vector<fastjet::PseudoJet> particlesBkg = thrm.createThermalEvent();
 
     for(fastjet::PseudoJet p : particlesBkg) {
-      const int & pdgid = p.user_info<extraInfo>().pdg_id();
-      const int & vtx   = p.user_info<extraInfo>().vertex_number();
+      const int & pdgid = pu14_info(p).pdg_id();
+      const int & vtx   = pu14_info(p).vertex_number();
       fout << p.px() << " " << p.py() << " " << p.pz() << " " << p.m() << " " << pdgid << " " << vtx << "\n";
     }
     fout << "end\n";
@@ -8,8 +8,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -22,11 +20,13 @@
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
 #include "include/jewelMatcher.hh"
 #include "include/SmearRandomKick.hh"
+#include "include/ghostSet.hh"
 
 // Observables
 //    1. Leading hadrons and ZBosons
@@ -67,6 +67,7 @@ int main(int argc, char *argv[])
 
    //to write info to root tree
    treeWriter Writer("JetTree");
+   Writer.openFile(cmdline.value<string>("-output", "JetToyHIResult.root"), cmdline.present("-resume"));
 
    //Jet definition
    double ghostRapMax         = 6.0;
@@ -92,28 +93,21 @@ int main(int argc, char *argv[])
    // Angularity width(1.,1.,R);
    // Angularity pTD(0.,2.,R);
 
-   ProgressBar Bar(cout, EventCount);
-   Bar.SetStyle(-1);
-
-   EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+   randomService::setSeed(cmdline.value<int>("-seed", 1));
+   EventMixer mixer(&cmdline, Writer.getResumeEvents());  //the mixing machinery from PU14 workshop
+   stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
    // loop over events
-   int iEvent = 0;
-   unsigned int EntryDiv = (EventCount > 200) ? EventCount / 200 : 1;
-   while ( mixer.next_event() && iEvent < EventCount )
+   eventLoop Loop(mixer, EventCount, cmdline.value<int>("-nthreads", 1));
+   Loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+   Loop.run(Writer, [&](const eventData &Event, treeWriter &Writer)
    {
-      // increment event number
-      iEvent = iEvent + 1;
-
-      Bar.Update(iEvent);
-      Bar.PrintWithMod(EntryDiv);
-
-      vector<PseudoJet> ParticlesMergedPreKick = mixer.particles();
+      vector<PseudoJet> ParticlesMergedPreKick = Event.particles;
       vector<PseudoJet> ParticlesMerged = SmearRandomKick(ParticlesMergedPreKick,kick);
       
       vector<double> EventWeight;
-      EventWeight.push_back(mixer.hard_weight());
-      EventWeight.push_back(mixer.pu_weight());
+      EventWeight.push_back(Event.hardWeight);
+      EventWeight.push_back(Event.puWeight);
 
       //---------------------------------------------------------------------------
       //   sort out particles
@@ -141,8 +135,8 @@ int main(int argc, char *argv[])
       vector<bool> Particle_isHadron;
       for(int i = 0; i < (int)ParticlesReal.size(); i++)
       {
-         const int &ID = ParticlesReal[i].user_info<PU14>().pdg_id();
-         Particle_pdg_id.push_back(ParticlesReal[i].user_info<PU14>().pdg_id());
+         const int &ID = pu14_info(ParticlesReal[i]).pdg_id();
+         Particle_pdg_id.push_back(pu14_info(ParticlesReal[i]).pdg_id());
          Particle_isHadron.push_back(HepPID::isHadron(ID));
       }
 
@@ -155,7 +149,7 @@ int main(int argc, char *argv[])
       
       for(int i = 0; i < (int)ParticlesReal.size(); i++)
       {
-         const int &ID = ParticlesReal[i].user_info<PU14>().pdg_id();
+         const int &ID = pu14_info(ParticlesReal[i]).pdg_id();
          if(HepPID::isHadron(ID) == false)
             continue;
          if(ParticlesReal[i].eta() < -3 || ParticlesReal[i].eta() > 3)
@@ -175,7 +169,7 @@ int main(int argc, char *argv[])
       int eMIndex=-1;
       for(int i = 0; i < (int)ParticlesSignal.size(); i++)
       {
-         const int &ID = ParticlesSignal[i].user_info<PU14>().pdg_id();
+         const int &ID = pu14_info(ParticlesSignal[i]).pdg_id();
          if (ePIndex>=0&&eMIndex>=0) continue;
          if(fabs(ID) != 13)
             continue;
@@ -300,20 +294,9 @@ int main(int argc, char *argv[])
       Writer.addCollection("Dummy", 	        ParticlesDummy);
       Writer.addCollection("EventWeight",      EventWeight);
 
-      Writer.fillTree();
-
-   } //event loop
-
-   Bar.Update(EventCount);
-   Bar.Print();
-   Bar.PrintLine();
-
-   TTree *trOut = Writer.getTree();
+   }); //event loop
 
-   TFile *fout = new TFile(cmdline.value<string>("-output", "JetToyHIResult.root").c_str(), "RECREATE");
-   trOut->Write();
-   fout->Write();
-   fout->Close();
+   Writer.closeFile();
 
    double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
       (chrono::steady_clock::now() - start_time).count() / 1000.0;
@@ -330,7 +313,7 @@ void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
    vector<PseudoJet> &Particles, vector<PseudoJet> &Dummy,
    Selector &JetSelector, string Tag)
 {
-   ClusterSequenceArea Cluster(Particles, Definition, Area);
+   ClusterSequenceArea Cluster(Particles, Definition, ghostSet::seeded(Area));
    jetCollection JC(sorted_by_pt(JetSelector(Cluster.inclusive_jets(10))));
    jetCollection JCJewel(GetCorrectedJets(JC.getJet(), Dummy));
 
@@ -393,7 +376,7 @@ void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
       vector<double> JCIsHadron;
       for(int i = 0; i < (int)J.constituents().size(); i++)
       {
-         const int &ID = J.constituents()[i].user_info<PU14>().pdg_id();
+         const int &ID = pu14_info(J.constituents()[i]).pdg_id();
          JCPDG.push_back((double)ID);
          JCIsHadron.push_back(HepPID::isHadron(ID));
 	 JCPt.push_back(J.constituents()[i].pt());
@@ -417,7 +400,7 @@ void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
       vector<double> JCSDIsHadron;
       for(int i = 0; i < (int)SD.getConstituents()[counter].size(); i++)
       {
-         const int &ID = SD.getConstituents()[counter][i].user_info<PU14>().pdg_id();
+         const int &ID = pu14_info(SD.getConstituents()[counter][i]).pdg_id();
          JCSDPDG.push_back((double)ID);
          JCSDIsHadron.push_back(HepPID::isHadron(ID));
 	 JCSDPt.push_back(SD.getConstituents()[counter][i].pt());
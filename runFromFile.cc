@@ -7,8 +7,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -16,9 +14,12 @@
 #include "include/jetCollection.hh"
 #include "include/csSubtractor.hh"
 #include "include/csSubtractorFullEvent.hh"
+#include "include/eventBackground.hh"
+#include "include/ghostSet.hh"
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
@@ -43,9 +44,11 @@ int main (int argc, char ** argv) {
 
   //to write info to root tree
   treeWriter trw("jetTree");
+  trw.openFile(cmdline.value<string>("-output", "JetToyHIResultFromFile.root"), cmdline.present("-resume"));
 
   //Jet definition
   double R                   = 0.4;
+  double jetRapMax           = 3.0;
   double ghostRapMax         = 6.0;
   double ghost_area          = 0.005;
   int    active_area_repeats = 1;
@@ -53,33 +56,29 @@ int main (int argc, char ** argv) {
   AreaDefinition area_def = AreaDefinition(active_area,ghost_spec);
   JetDefinition jet_def(antikt_algorithm, R);
 
-  double jetRapMax = 3.0;
   Selector jet_selector = SelectorAbsRapMax(jetRapMax);
 
+  //full event constituent subtraction (slow, so only with -csglobal)
+  bool doCSGlobal = cmdline.present("-csglobal");
+
   Angularity width(1.,1.,R);
   Angularity pTD(0.,2.,R);
     
-  ProgressBar Bar(cout, nEvent);
-  Bar.SetStyle(-1);
 
-  EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+  randomService::setSeed(cmdline.value<int>("-seed", 1));
+  EventMixer mixer(&cmdline, trw.getResumeEvents());  //the mixing machinery from PU14 workshop
+  stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
   // loop over events
-  int iev = 0;
-  unsigned int entryDiv = (nEvent > 200) ? nEvent / 200 : 1;
-  while ( mixer.next_event() && iev < nEvent )
+  eventLoop loop(mixer, nEvent, cmdline.value<int>("-nthreads", 1));
+  loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+  loop.run(trw, [&](const eventData &event, treeWriter &trw)
   {
-    // increment event number    
-    iev++;
-
-    Bar.Update(iev);
-    Bar.PrintWithMod(entryDiv);
-
-    vector<PseudoJet> particlesMerged = mixer.particles();
+    vector<PseudoJet> particlesMerged = event.particles;
 
     vector<double> eventWeight;
-    eventWeight.push_back(mixer.hard_weight());
-    eventWeight.push_back(mixer.pu_weight());
+    eventWeight.push_back(event.hardWeight);
+    eventWeight.push_back(event.puWeight);
 
     // cluster hard event only
     vector<PseudoJet> particlesDummy, particlesReal;
@@ -100,15 +99,24 @@ int main (int argc, char ** argv) {
     //   jet clustering
     //---------------------------------------------------------------------------
     
-    // run the clustering, extract the jets
-    ClusterSequenceArea csMerged(particlesMerged, jet_def, area_def);
-    jetCollection jetCollectionMerged(sorted_by_pt(jet_selector(csMerged.inclusive_jets())));
+    // run the clustering, extract the jets (with explicit ghosts, so the
+    // constituent subtraction below can reuse this clustering and its
+    // background estimate the ghosts)
+    scopedTimer mergedTimer("clusterMerged");
+    ghostSet ghosts(ghostRapMax, ghost_area);
+    ClusterSequenceActiveAreaExplicitGhosts csMerged(particlesMerged, jet_def, ghosts.getGhosts(), ghosts.getGhostArea());
+    jetCollection jetCollectionMerged(sorted_by_pt((jet_selector && !SelectorIsPureGhost())(csMerged.inclusive_jets())));
+    mergedTimer.stop();
+    stageTimer::count("particles", particlesMerged.size());
+    stageTimer::count("ghosts", ghosts.getGhosts().size());
 
     // ClusterSequenceArea csBkg(particlesBkg, jet_def, area_def);
     // jetCollection jetCollectionBkg(sorted_by_pt(csBkg.inclusive_jets()));
 
-    ClusterSequenceArea csSig(particlesSig, jet_def, area_def);
+    scopedTimer sigTimer("clusterSignal");
+    ClusterSequenceArea csSig(particlesSig, jet_def, ghostSet::seeded(area_def));
     jetCollection jetCollectionSig(sorted_by_pt(jet_selector(csSig.inclusive_jets(10.))));
+    sigTimer.stop();
     jetCollection jetCollectionSigJewel(GetCorrectedJets(jetCollectionSig.getJet(), particlesDummy));
 
     //calculate some angularities
@@ -128,6 +136,11 @@ int main (int argc, char ** argv) {
     //run jet-by-jet constituent subtraction on mixed (hard+UE) event
     csSubtractor csSub(R, 1., -1, 0.005,ghostRapMax,jetRapMax);
     csSub.setInputParticles(particlesMerged);
+    csSub.setInputJets(csMerged.inclusive_jets());
+    eventBackground background(ghostRapMax, ghost_area, jetRapMax - 0.4);
+    background.setGhosts(&ghosts);
+    background.setInputParticles(particlesMerged);
+    csSub.setBackground(&background);
     jetCollection jetCollectionCS(csSub.doSubtraction());
     jetCollection jetCollectionCSJewel(GetCorrectedJets(jetCollectionCS.getJet(), particlesDummy));
 
@@ -146,15 +159,19 @@ int main (int argc, char ** argv) {
     jetCollectionCS.addVector("pTDCS", pTDCS);
 
     //run full event constituent subtraction on mixed (hard+UE) event
-    // csSubtractorFullEvent csSubGlobal(1., R, 0.005,ghostRapMax);
-    // csSubGlobal.setRho(rho[0]);
-    // csSubGlobal.setRhom(rhom[0]);
-    // csSubGlobal.setInputParticles(particlesMerged);
-    // vector<PseudoJet> csEvent = csSubGlobal.doSubtraction();
-
-    //cluster jets from constituent subtracted event
-    // ClusterSequenceArea csGlobal(csEvent, jet_def, area_def);
-    // jetCollection jetCollectionCSGlobal(sorted_by_pt(jet_selector(csGlobal.inclusive_jets())));
+    //(option -csglobal)
+    if(doCSGlobal) {
+      csSubtractorFullEvent csSubGlobal(1., R, 0.005,ghostRapMax);
+      csSubGlobal.setRho(rho[0]);
+      csSubGlobal.setRhom(rhom[0]);
+      csSubGlobal.setInputParticles(particlesMerged);
+      vector<PseudoJet> csEvent = csSubGlobal.doSubtraction();
+
+      //cluster jets from constituent subtracted event
+      ClusterSequenceArea csGlobal(csEvent, jet_def, ghostSet::seeded(area_def));
+      jetCollection jetCollectionCSGlobal(sorted_by_pt(jet_selector(csGlobal.inclusive_jets())));
+      trw.addCollection("csGlobJet",   jetCollectionCSGlobal);
+    }
 
     //Uncomment if youw ant to study random cones
     // randomCones rc(4,R,2.3,rho[0]);
@@ -169,8 +186,10 @@ int main (int argc, char ** argv) {
     skPtThreshold.push_back(skSub.getPtThreshold()); //SoftKiller pT threshold
 
     //cluster jets for soft killed event
-    ClusterSequenceArea csSK(skEvent, jet_def, area_def);
+    scopedTimer skTimer("clusterSoftKiller");
+    ClusterSequenceArea csSK(skEvent, jet_def, ghostSet::seeded(area_def));
     jetCollection jetCollectionSK(sorted_by_pt(jet_selector(csSK.inclusive_jets())));
+    skTimer.stop();
 
     //---------------------------------------------------------------------------
     //   Groom the jets
@@ -251,7 +270,6 @@ int main (int argc, char ** argv) {
     trw.addCollection("csJetSD",       jetCollectionCSSD);
     trw.addCollection("csJetSDJewel",  jetCollectionCSSDJewel);
     trw.addCollection("skJet",         jetCollectionSK);
-    // trw.addCollection("csGlobJet",     jetCollectionCSGlobal);
     // trw.addCollection("randomCones",   jetCollectionRC);
 
     trw.addCollection("csRho",         rho);
@@ -261,20 +279,10 @@ int main (int argc, char ** argv) {
 
     trw.addCollection("unsubJet",      jetCollectionMerged);
         
-    trw.fillTree();
-
-  }//event loop
-
-  Bar.Update(nEvent);
-  Bar.Print();
-  Bar.PrintLine();
 
-  TTree *trOut = trw.getTree();
+  });//event loop
 
-  TFile *fout = new TFile(cmdline.value<string>("-output", "JetToyHIResultFromFile.root").c_str(), "RECREATE");
-  trOut->Write();
-  fout->Write();
-  fout->Close();
+  trw.closeFile();
 
   double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
     (chrono::steady_clock::now() - start_time).count() / 1000.0;
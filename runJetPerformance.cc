@@ -7,8 +7,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -19,9 +17,11 @@
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
+#include "include/ghostSet.hh"
 
 using namespace std;
 using namespace fastjet;
@@ -47,6 +47,7 @@ int main (int argc, char ** argv) {
 
   //to write info to root tree
   treeWriter trw("jetTree");
+  trw.openFile("JetToyHIResultJetPerformance.root", cmdline.present("-resume"));
 
   //Jet definition
   double R                   = 0.4;
@@ -63,27 +64,21 @@ int main (int argc, char ** argv) {
   Angularity width(1.,1.,R);
   Angularity pTD(0.,2.,R);
     
-  ProgressBar Bar(cout, nEvent);
-  Bar.SetStyle(-1);
 
-  EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+  randomService::setSeed(cmdline.value<int>("-seed", 1));
+  EventMixer mixer(&cmdline, trw.getResumeEvents());  //the mixing machinery from PU14 workshop
+  stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
   // loop over events
-  int iev = 0;
-  unsigned int entryDiv = (nEvent > 200) ? nEvent / 200 : 1;
-  while ( mixer.next_event() && iev < nEvent )
+  eventLoop loop(mixer, nEvent, cmdline.value<int>("-nthreads", 1));
+  loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+  loop.run(trw, [&](const eventData &event, treeWriter &trw)
   {
-    // increment event number    
-    iev++;
-
-    Bar.Update(iev);
-    Bar.PrintWithMod(entryDiv);
-
-    std::vector<fastjet::PseudoJet> particlesMerged = mixer.particles();
+    std::vector<fastjet::PseudoJet> particlesMerged = event.particles;
     
     std::vector<double> eventWeight;
-    eventWeight.push_back(mixer.hard_weight());
-    eventWeight.push_back(mixer.pu_weight());
+    eventWeight.push_back(event.hardWeight);
+    eventWeight.push_back(event.puWeight);
 
     // cluster hard event only
     std::vector<fastjet::PseudoJet> particlesBkg, particlesSig;
@@ -94,7 +89,7 @@ int main (int argc, char ** argv) {
     //---------------------------------------------------------------------------
     
     // run the clustering, extract the signal jets
-    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, area_def);
+    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, ghostSet::seeded(area_def));
     jetCollection jetCollectionSig(sorted_by_pt(jet_selector(csSig.inclusive_jets(10.))));
 
     //---------------------------------------------------------------------------
@@ -124,23 +119,23 @@ int main (int argc, char ** argv) {
     //run soft killer on mixed event
     const int nsk = 7;
     double gridsize[nsk] = {0.2,0.25,0.3,0.35,0.4,0.45,0.5};
-    //skSubtractor skSub[nsk];
-    std::vector<std::vector<fastjet::PseudoJet>> skEvents;// skEvents.reserve(nsk);
     std::vector<std::vector<double>> skPtThresholds;      // skPtThresholds.reserve(nsk);
     std::vector<jetCollection> jetCollectionSKs;          // jetCollectionSKs.reserve(nsk);
+
+    //the thresholds of all grid sizes from one pass over the event
+    skSubtractor skScan(std::vector<double>(gridsize, gridsize + nsk), 3.0);
+    skScan.setInputParticles(particlesMerged);
+    std::vector<double> skThresholds = skScan.doThresholds();
     
     for(int is = 0; is<nsk; ++is) {
-      skSubtractor skSub(gridsize[is], 3.0);
-      skSub.setInputParticles(particlesMerged);
-      std::vector<fastjet::PseudoJet> skEvent = skSub.doSubtraction();
+      std::vector<fastjet::PseudoJet> skEvent = skScan.getSubtractedEvent(is);
       std::vector<double> skPtThreshold;
-      skPtThreshold.push_back(skSub.getPtThreshold()); //SoftKiller pT threshold
+      skPtThreshold.push_back(skThresholds[is]); //SoftKiller pT threshold
 
       //cluster jets for soft killed event
-      fastjet::ClusterSequenceArea csSK(skEvent, jet_def, area_def);
+      fastjet::ClusterSequenceArea csSK(skEvent, jet_def, ghostSet::seeded(area_def));
       jetCollection jetCollectionSK(sorted_by_pt(jet_selector(csSK.inclusive_jets())));
       
-      skEvents.push_back(skEvent);
       skPtThresholds.push_back(skPtThreshold);
       jetCollectionSKs.push_back(jetCollectionSK);
     }
@@ -195,20 +190,9 @@ int main (int argc, char ** argv) {
     trw.addCollection("csRhom",        rhom);
     trw.addCollection("eventWeight",   eventWeight);
 
-    trw.fillTree();
-
-  }//event loop
-
-  Bar.Update(nEvent);
-  Bar.Print();
-  Bar.PrintLine();
-
-  TTree *trOut = trw.getTree();
+  });//event loop
 
-  TFile *fout = new TFile("JetToyHIResultJetPerformance.root","RECREATE");
-  trOut->Write();
-  fout->Write();
-  fout->Close();
+  trw.closeFile();
 
   double time_in_seconds = std::chrono::duration_cast<std::chrono::milliseconds>
     (std::chrono::steady_clock::now() - start_time).count() / 1000.0;
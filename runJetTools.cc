@@ -8,8 +8,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -22,10 +20,12 @@
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
 #include "include/jewelMatcher.hh"
+#include "include/ghostSet.hh"
 
 // Observables
 //    1. Leading hadrons and photons
@@ -62,6 +62,7 @@ int main(int argc, char *argv[])
 
    //to write info to root tree
    treeWriter Writer("JetTree");
+   Writer.openFile(cmdline.value<string>("-output", "JetToyHIResult.root"), cmdline.present("-resume"));
 
    //Jet definition
    double ghostRapMax         = 6.0;
@@ -87,27 +88,20 @@ int main(int argc, char *argv[])
    // Angularity width(1.,1.,R);
    // Angularity pTD(0.,2.,R);
 
-   ProgressBar Bar(cout, EventCount);
-   Bar.SetStyle(-1);
-
-   EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+   randomService::setSeed(cmdline.value<int>("-seed", 1));
+   EventMixer mixer(&cmdline, Writer.getResumeEvents());  //the mixing machinery from PU14 workshop
+   stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
    // loop over events
-   int iEvent = 0;
-   unsigned int EntryDiv = (EventCount > 200) ? EventCount / 200 : 1;
-   while ( mixer.next_event() && iEvent < EventCount )
+   eventLoop Loop(mixer, EventCount, cmdline.value<int>("-nthreads", 1));
+   Loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+   Loop.run(Writer, [&](const eventData &Event, treeWriter &Writer)
    {
-      // increment event number
-      iEvent = iEvent + 1;
-
-      Bar.Update(iEvent);
-      Bar.PrintWithMod(EntryDiv);
-
-      vector<PseudoJet> ParticlesMerged = mixer.particles();
+      vector<PseudoJet> ParticlesMerged = Event.particles;
 
       vector<double> EventWeight;
-      EventWeight.push_back(mixer.hard_weight());
-      EventWeight.push_back(mixer.pu_weight());
+      EventWeight.push_back(Event.hardWeight);
+      EventWeight.push_back(Event.puWeight);
 
       //---------------------------------------------------------------------------
       //   sort out particles
@@ -134,7 +128,7 @@ int main(int argc, char *argv[])
       vector<PseudoJet> LeadingHadron;
       for(int i = 0; i < (int)ParticlesReal.size(); i++)
       {
-         const int &ID = ParticlesReal[i].user_info<PU14>().pdg_id();
+         const int &ID = pu14_info(ParticlesReal[i]).pdg_id();
          if(HepPID::isHadron(ID) == false)
             continue;
          if(ParticlesReal[i].eta() < -3 || ParticlesReal[i].eta() > 3)
@@ -152,7 +146,7 @@ int main(int argc, char *argv[])
       int PhotonIndex = -1;
       for(int i = 0; i < (int)ParticlesSignal.size(); i++)
       {
-         const int &ID = ParticlesSignal[i].user_info<PU14>().pdg_id();
+         const int &ID = pu14_info(ParticlesSignal[i]).pdg_id();
 
          if(ID != 22)
             continue;
@@ -273,20 +267,9 @@ int main(int argc, char *argv[])
       
       Writer.addCollection("EventWeight",      EventWeight);
 
-      Writer.fillTree();
-
-   } //event loop
-
-   Bar.Update(EventCount);
-   Bar.Print();
-   Bar.PrintLine();
-
-   TTree *trOut = Writer.getTree();
+   }); //event loop
 
-   TFile *fout = new TFile(cmdline.value<string>("-output", "JetToyHIResult.root").c_str(), "RECREATE");
-   trOut->Write();
-   fout->Write();
-   fout->Close();
+   Writer.closeFile();
 
    double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
       (chrono::steady_clock::now() - start_time).count() / 1000.0;
@@ -303,7 +286,7 @@ void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
    vector<PseudoJet> &Particles, vector<PseudoJet> &Dummy,
    Selector &JetSelector, string Tag)
 {
-   ClusterSequenceArea Cluster(Particles, Definition, Area);
+   ClusterSequenceArea Cluster(Particles, Definition, ghostSet::seeded(Area));
    jetCollection JC(sorted_by_pt(JetSelector(Cluster.inclusive_jets(10))));
    jetCollection JCJewel(GetCorrectedJets(JC.getJet(), Dummy));
 
@@ -8,8 +8,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -17,11 +15,13 @@
 
 #include "include/extraInfo.hh"
 #include "include/jetCollection.hh"
+#include "include/multiRClustering.hh"
 #include "include/csSubtractor.hh"
 #include "include/csSubtractorFullEvent.hh"
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
@@ -43,10 +43,7 @@ using namespace fastjet;
 
 int main(int argc, char *argv[]);
 bool CompareJet(const PseudoJet &J1, const PseudoJet &J2);
-void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
-   JetDefinition &SubjetDefinition, JetDefinition &WTADefinition, double R,
-   vector<PseudoJet> &Particles, vector<PseudoJet> &Dummy,
-   Selector &JetSelector, string Tag);
+void DoJet(treeWriter &Writer, jetCollection &JC, vector<PseudoJet> &Dummy, string Tag);
 
 int main(int argc, char *argv[])
 {
@@ -67,55 +64,35 @@ int main(int argc, char *argv[])
 
    //to write info to root tree
    treeWriter Writer("JetTree");
+   Writer.openFile(cmdline.value<string>("-output", "JetToyHIResult.root"), cmdline.present("-resume"));
 
-   //Jet definition
+   //Jet definition: all radii of the scan are clustered by one multiRClustering
    double ghostRapMax         = 6.0;
    double ghost_area          = 0.005;
-   int    active_area_repeats = 1;
-   GhostedAreaSpec ghost_spec(ghostRapMax, active_area_repeats, ghost_area);
-   AreaDefinition Area = AreaDefinition(active_area, ghost_spec);
-   JetDefinition JetDefinition01(antikt_algorithm, 0.1);
-   JetDefinition JetDefinition02(antikt_algorithm, 0.2);
-   JetDefinition JetDefinition04(antikt_algorithm, 0.4);
-   JetDefinition JetDefinition06(antikt_algorithm, 0.6);
-   JetDefinition JetDefinition08(antikt_algorithm, 0.8);
-   JetDefinition JetDefinition10(antikt_algorithm, 1.0);
-   
-   JetDefinition WTADefinition(antikt_algorithm, 10.0, WTA_pt_scheme);
-   JetDefinition WTADefinition02(antikt_algorithm, 0.2, WTA_pt_scheme);
-   JetDefinition WTADefinition04(antikt_algorithm, 0.4, WTA_pt_scheme);
-   JetDefinition WTADefinition06(antikt_algorithm, 0.6, WTA_pt_scheme);
-   JetDefinition WTADefinition08(antikt_algorithm, 0.8, WTA_pt_scheme);
-   JetDefinition WTADefinition10(antikt_algorithm, 1.0, WTA_pt_scheme);
-   
-   
-   Selector JetSelector = SelectorAbsRapMax(3.0);
+   double JetRapMax           = 3.0;
+   double JetPTMin            = 10;
+   vector<double> JetRadii    = {0.2, 0.3, 0.4, 0.6, 0.8, 1.0};
+   vector<string> JetTags     = {"02", "03", "04", "06", "08", "10"};
+   int ClusteringThreads      = cmdline.value<int>("-rthreads", 1);
 
    // Angularity width(1.,1.,R);
    // Angularity pTD(0.,2.,R);
 
-   ProgressBar Bar(cout, EventCount);
-   Bar.SetStyle(-1);
-
-   EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+   randomService::setSeed(cmdline.value<int>("-seed", 1));
+   EventMixer mixer(&cmdline, Writer.getResumeEvents());  //the mixing machinery from PU14 workshop
+   stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
    // loop over events
-   int iEvent = 0;
-   unsigned int EntryDiv = (EventCount > 200) ? EventCount / 200 : 1;
-   while ( mixer.next_event() && iEvent < EventCount )
+   eventLoop Loop(mixer, EventCount, cmdline.value<int>("-nthreads", 1));
+   Loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+   Loop.run(Writer, [&](const eventData &Event, treeWriter &Writer)
    {
-      // increment event number
-      iEvent = iEvent + 1;
-
-      Bar.Update(iEvent);
-      Bar.PrintWithMod(EntryDiv);
-
-      vector<PseudoJet> ParticlesMergedPreKick = mixer.particles();
+      vector<PseudoJet> ParticlesMergedPreKick = Event.particles;
       vector<PseudoJet> ParticlesMerged = SmearRandomKick(ParticlesMergedPreKick,kick);
       
       vector<double> EventWeight;
-      EventWeight.push_back(mixer.hard_weight());
-      EventWeight.push_back(mixer.pu_weight());
+      EventWeight.push_back(Event.hardWeight);
+      EventWeight.push_back(Event.puWeight);
 
       //---------------------------------------------------------------------------
       //   sort out particles
@@ -140,31 +117,32 @@ int main(int argc, char *argv[])
       //   Jet clustering
       //---------------------------------------------------------------------------
 
-       DoJet(Writer, JetDefinition02, Area, JetDefinition01, WTADefinition, 0.2, ParticlesSignal, ParticlesDummy, JetSelector, "SignalJet02");
-       DoJet(Writer, JetDefinition02, Area, JetDefinition01, WTADefinition, 0.3, ParticlesSignal, ParticlesDummy, JetSelector, "SignalJet03");
-      DoJet(Writer, JetDefinition04, Area, JetDefinition01, WTADefinition, 0.4, ParticlesSignal, ParticlesDummy, JetSelector, "SignalJet04");
-       DoJet(Writer, JetDefinition06, Area, JetDefinition01, WTADefinition, 0.6, ParticlesSignal, ParticlesDummy, JetSelector, "SignalJet06");
-       DoJet(Writer, JetDefinition08, Area, JetDefinition01, WTADefinition, 0.8, ParticlesSignal, ParticlesDummy, JetSelector, "SignalJet08");
-       DoJet(Writer, JetDefinition10, Area, JetDefinition01, WTADefinition, 1.0, ParticlesSignal, ParticlesDummy, JetSelector, "SignalJet10");
-
-/*      
-       DoJet(Writer, JetDefinition02, Area, JetDefinition01, WTADefinition, 0.2, ParticlesReal, ParticlesDummy, JetSelector, "AllJet02");
-      DoJet(Writer, JetDefinition04, Area, JetDefinition01, WTADefinition, 0.4, ParticlesReal, ParticlesDummy, JetSelector, "AllJet04");
-       DoJet(Writer, JetDefinition06, Area, JetDefinition01, WTADefinition, 0.6, ParticlesReal, ParticlesDummy, JetSelector, "AllJet06");
-       DoJet(Writer, JetDefinition08, Area, JetDefinition01, WTADefinition, 0.8, ParticlesReal, ParticlesDummy, JetSelector, "AllJet08");
-       DoJet(Writer, JetDefinition10, Area, JetDefinition01, WTADefinition, 1.0, ParticlesReal, ParticlesDummy, JetSelector, "AllJet10");
-
-       DoJet(Writer, WTADefinition02, Area, JetDefinition01, WTADefinition, 0.2, ParticlesSignal, ParticlesDummy, JetSelector, "WTASignalJet02");
-      DoJet(Writer, WTADefinition04, Area, JetDefinition01, WTADefinition, 0.4, ParticlesSignal, ParticlesDummy, JetSelector, "WTASignalJet04");
-       DoJet(Writer, WTADefinition06, Area, JetDefinition01, WTADefinition, 0.6, ParticlesSignal, ParticlesDummy, JetSelector, "WTASignalJet06");
-       DoJet(Writer, WTADefinition08, Area, JetDefinition01, WTADefinition, 0.8, ParticlesSignal, ParticlesDummy, JetSelector, "WTASignalJet08");
-       DoJet(Writer, WTADefinition10, Area, JetDefinition01, WTADefinition, 1.0, ParticlesSignal, ParticlesDummy, JetSelector, "WTASignalJet10");
-      
-      DoJet(Writer, WTADefinition02, Area, JetDefinition01, WTADefinition, 0.2, ParticlesReal, ParticlesDummy, JetSelector, "WTAAllJet02");
-      DoJet(Writer, WTADefinition04, Area, JetDefinition01, WTADefinition, 0.4, ParticlesReal, ParticlesDummy, JetSelector, "WTAAllJet04");
-      DoJet(Writer, WTADefinition06, Area, JetDefinition01, WTADefinition, 0.6, ParticlesReal, ParticlesDummy, JetSelector, "WTAAllJet06");
-      DoJet(Writer, WTADefinition08, Area, JetDefinition01, WTADefinition, 0.8, ParticlesReal, ParticlesDummy, JetSelector, "WTAAllJet08");
-      DoJet(Writer, WTADefinition10, Area, JetDefinition01, WTADefinition, 1.0, ParticlesReal, ParticlesDummy, JetSelector, "WTAAllJet10");
+      multiRClustering SignalClustering(JetRadii, JetRapMax, JetPTMin, ghost_area, ClusteringThreads, ghostRapMax);
+      SignalClustering.setInputParticles(ParticlesSignal);
+      vector<jetCollection> SignalJets = SignalClustering.doClustering();
+      for(int i = 0; i < (int)JetRadii.size(); i++)
+         DoJet(Writer, SignalJets[i], ParticlesDummy, "SignalJet" + JetTags[i]);
+
+/*
+      multiRClustering AllClustering(JetRadii, JetRapMax, JetPTMin, ghost_area, ClusteringThreads, ghostRapMax);
+      AllClustering.setInputParticles(ParticlesReal);
+      vector<jetCollection> AllJets = AllClustering.doClustering();
+      for(int i = 0; i < (int)JetRadii.size(); i++)
+         DoJet(Writer, AllJets[i], ParticlesDummy, "AllJet" + JetTags[i]);
+
+      multiRClustering WTASignalClustering(JetRadii, JetRapMax, JetPTMin, ghost_area, ClusteringThreads, ghostRapMax);
+      WTASignalClustering.setAlgorithm(antikt_algorithm, WTA_pt_scheme);
+      WTASignalClustering.setInputParticles(ParticlesSignal);
+      vector<jetCollection> WTASignalJets = WTASignalClustering.doClustering();
+      for(int i = 0; i < (int)JetRadii.size(); i++)
+         DoJet(Writer, WTASignalJets[i], ParticlesDummy, "WTASignalJet" + JetTags[i]);
+
+      multiRClustering WTAAllClustering(JetRadii, JetRapMax, JetPTMin, ghost_area, ClusteringThreads, ghostRapMax);
+      WTAAllClustering.setAlgorithm(antikt_algorithm, WTA_pt_scheme);
+      WTAAllClustering.setInputParticles(ParticlesReal);
+      vector<jetCollection> WTAAllJets = WTAAllClustering.doClustering();
+      for(int i = 0; i < (int)JetRadii.size(); i++)
+         DoJet(Writer, WTAAllJets[i], ParticlesDummy, "WTAAllJet" + JetTags[i]);
 */
       //---------------------------------------------------------------------------
       //   Write tree
@@ -175,20 +153,9 @@ int main(int argc, char *argv[])
 
       Writer.addCollection("EventWeight",      EventWeight);
 
-      Writer.fillTree();
-
-   } //event loop
-
-   Bar.Update(EventCount);
-   Bar.Print();
-   Bar.PrintLine();
-
-   TTree *trOut = Writer.getTree();
+   }); //event loop
 
-   TFile *fout = new TFile(cmdline.value<string>("-output", "JetToyHIResult.root").c_str(), "RECREATE");
-   trOut->Write();
-   fout->Write();
-   fout->Close();
+   Writer.closeFile();
 
    double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
       (chrono::steady_clock::now() - start_time).count() / 1000.0;
@@ -200,13 +167,8 @@ bool CompareJet(const PseudoJet &J1, const PseudoJet &J2)
    return (J1.perp() > J2.perp());
 } 
 
-void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
-   JetDefinition &SubjetDefinition, JetDefinition &WTADefinition, double R,
-   vector<PseudoJet> &Particles, vector<PseudoJet> &Dummy,
-   Selector &JetSelector, string Tag)
+void DoJet(treeWriter &Writer, jetCollection &JC, vector<PseudoJet> &Dummy, string Tag)
 {
-   ClusterSequenceArea Cluster(Particles, Definition, Area);
-   jetCollection JC(sorted_by_pt(JetSelector(Cluster.inclusive_jets(10))));
    jetCollection JCJewel(GetCorrectedJets(JC.getJet(), Dummy));
 
    Writer.addCollection(Tag + "",        JC);
@@ -7,8 +7,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -19,10 +17,12 @@
 #include "include/skSubtractor.hh"
 #include "include/softDropGroomer.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
 #include "include/jewelMatcher.hh"
+#include "include/ghostSet.hh"
 
 using namespace std;
 using namespace fastjet;
@@ -45,6 +45,7 @@ int main (int argc, char ** argv) {
 
   //to write info to root tree
   treeWriter trw("jetTree");
+  trw.openFile(cmdline.value<string>("-output", "JetToyHIResulJewelSub.root"), cmdline.present("-resume"));
 
   //Jet definition
   double R                   = 0.4;
@@ -61,27 +62,21 @@ int main (int argc, char ** argv) {
   Angularity width(1.,1.,R);
   Angularity pTD(0.,2.,R);
     
-  ProgressBar Bar(cout, nEvent);
-  Bar.SetStyle(-1);
 
-  EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+  randomService::setSeed(cmdline.value<int>("-seed", 1));
+  EventMixer mixer(&cmdline, trw.getResumeEvents());  //the mixing machinery from PU14 workshop
+  stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
   // loop over events
-  int iev = 0;
-  unsigned int entryDiv = (nEvent > 200) ? nEvent / 200 : 1;
-  while ( mixer.next_event() && iev < nEvent )
+  eventLoop loop(mixer, nEvent, cmdline.value<int>("-nthreads", 1));
+  loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+  loop.run(trw, [&](const eventData &event, treeWriter &trw)
   {
-    // increment event number    
-    iev++;
-
-    Bar.Update(iev);
-    Bar.PrintWithMod(entryDiv);
-
-    vector<PseudoJet> particlesMerged = mixer.particles();
+    vector<PseudoJet> particlesMerged = event.particles;
 
     vector<double> eventWeight;
-    eventWeight.push_back(mixer.hard_weight());
-    eventWeight.push_back(mixer.pu_weight());
+    eventWeight.push_back(event.hardWeight);
+    eventWeight.push_back(event.puWeight);
 
     // cluster hard event only
     vector<PseudoJet> particlesDummy, particlesReal;
@@ -102,7 +97,7 @@ int main (int argc, char ** argv) {
     //   jet clustering
     //---------------------------------------------------------------------------
     
-    ClusterSequenceArea csSig(particlesSig, jet_def, area_def);
+    ClusterSequenceArea csSig(particlesSig, jet_def, ghostSet::seeded(area_def));
     jetCollection jetCollectionSig(sorted_by_pt(jet_selector(csSig.inclusive_jets(10.))));
     jetCollection jetCollectionSigJewel(GetCorrectedJets(jetCollectionSig.getJet(), particlesDummy));
 
@@ -135,20 +130,10 @@ int main (int argc, char ** argv) {
     trw.addCollection("sigJetSDJewel", jetCollectionSigSDJewel);
     trw.addCollection("eventWeight",   eventWeight);
         
-    trw.fillTree();
-
-  }//event loop
-
-  Bar.Update(nEvent);
-  Bar.Print();
-  Bar.PrintLine();
 
-  TTree *trOut = trw.getTree();
+  });//event loop
 
-  TFile *fout = new TFile(cmdline.value<string>("-output", "JetToyHIResulJewelSub.root").c_str(), "RECREATE");
-  trOut->Write();
-  fout->Write();
-  fout->Close();
+  trw.closeFile();
 
   double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
     (chrono::steady_clock::now() - start_time).count() / 1000.0;
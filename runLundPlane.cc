@@ -8,8 +8,6 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
@@ -23,10 +21,12 @@
 #include "include/softDropGroomer.hh"
 #include "include/softDropCounter.hh"
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
 #include "include/Angularity.hh"
 #include "include/jewelMatcher.hh"
+#include "include/ghostSet.hh"
 
 using namespace std;
 using namespace fastjet;
@@ -59,6 +59,7 @@ int main(int argc, char *argv[])
 
    //to write info to root tree
    treeWriter Writer("JetTree");
+   Writer.openFile(cmdline.value<string>("-output", "JetToyHIResult.root"), cmdline.present("-resume"));
 
    //Jet definition
    double JetR                = cmdline.value<double>("-r", 0.4);
@@ -71,27 +72,21 @@ int main(int argc, char *argv[])
 
    Selector JetSelector = SelectorAbsRapMax(3.0);
 
-   ProgressBar Bar(cout, EventCount);
-   Bar.SetStyle(-1);
-
-   EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+   randomService::setSeed(cmdline.value<int>("-seed", 1));
+   EventMixer mixer(&cmdline, Writer.getResumeEvents());  //the mixing machinery from PU14 workshop
+   stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
    // loop over events
-   int iEvent = 0;
-   unsigned int EntryDiv = (EventCount > 200) ? EventCount / 200 : 1;
-   while ( mixer.next_event() && iEvent < EventCount )
+   eventLoop Loop(mixer, EventCount, cmdline.value<int>("-nthreads", 1));
+   Loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+   Loop.keepHardList();
+   Loop.run(Writer, [&](const eventData &Event, treeWriter &Writer)
    {
-      // increment event number
-      iEvent = iEvent + 1;
-
-      Bar.Update(iEvent);
-      Bar.PrintWithMod(EntryDiv);
-
-      vector<PseudoJet> ParticlesMerged = mixer.particles();
+      vector<PseudoJet> ParticlesMerged = Event.particles;
 
       vector<double> EventWeight;
-      EventWeight.push_back(mixer.hard_weight());
-      EventWeight.push_back(mixer.pu_weight());
+      EventWeight.push_back(Event.hardWeight);
+      EventWeight.push_back(Event.puWeight);
 
       //---------------------------------------------------------------------------
       //   sort out particles
@@ -121,7 +116,7 @@ int main(int argc, char *argv[])
       
       if(DoPythiaShower)
       {
-         const EventList &List = mixer.get_hard_list();
+         const EventList &List = Event.hardList;
 
          vector<int> HardParticles = List.GetListByStatus(23);   // pythia8
 
@@ -151,7 +146,7 @@ int main(int argc, char *argv[])
 
       string Tag = "SignalJet";
 
-      ClusterSequenceArea Cluster(ParticlesReal, Definition, Area);
+      ClusterSequenceArea Cluster(ParticlesReal, Definition, ghostSet::seeded(Area));
       jetCollection JC(sorted_by_pt(JetSelector(Cluster.inclusive_jets(10))));
       jetCollection JCJewel(GetCorrectedJets(JC.getJet(), ParticlesDummy));
 
@@ -328,20 +323,9 @@ int main(int argc, char *argv[])
          Writer.addCollection("PartonSJ2s",       PartonSJ2);
       }
 
-      Writer.fillTree();
-
-   } //event loop
-
-   Bar.Update(EventCount);
-   Bar.Print();
-   Bar.PrintLine();
-
-   TTree *trOut = Writer.getTree();
+   }); //event loop
 
-   TFile *fout = new TFile(cmdline.value<string>("-output", "JetToyHIResult.root").c_str(), "RECREATE");
-   trOut->Write();
-   fout->Write();
-   fout->Close();
+   Writer.closeFile();
 
    double time_in_seconds = chrono::duration_cast<chrono::milliseconds>
       (chrono::steady_clock::now() - start_time).count() / 1000.0;
@@ -358,7 +342,7 @@ void DoJet(treeWriter &Writer, JetDefinition &Definition, AreaDefinition Area,
    vector<PseudoJet> &Particles, vector<PseudoJet> &Dummy,
    Selector &JetSelector, string Tag)
 {
-   ClusterSequenceArea Cluster(Particles, Definition, Area);
+   ClusterSequenceArea Cluster(Particles, Definition, ghostSet::seeded(Area));
    jetCollection JC(sorted_by_pt(JetSelector(Cluster.inclusive_jets(10))));
    jetCollection JCJewel(GetCorrectedJets(JC.getJet(), Dummy));
 
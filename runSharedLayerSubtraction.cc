@@ -7,16 +7,17 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
-#include "include/ProgressBar.h"
-
 #include "PU14/EventMixer.hh"
 #include "PU14/CmdLine.hh"
 #include "PU14/PU14.hh"
 
 #include "include/jetCollection.hh"
 #include "include/sharedLayerSubtractor.hh"
+#include "include/eventBackground.hh"
+#include "include/ghostSet.hh"
 
 #include "include/treeWriter.hh"
+#include "include/eventLoop.hh"
 #include "include/jetMatcher.hh"
 
 using namespace std;
@@ -40,9 +41,11 @@ int main (int argc, char ** argv) {
 
   //to write info to root tree
   treeWriter trw("jetTree");
+  trw.openFile("JetToyHIResultSharedLayers.root", cmdline.present("-resume"));
 
   //Jet definition
   double R                   = 0.4;
+  double jetRapMax           = 3.0;
   double ghostRapMax         = 6.0;
   double ghost_area          = 0.005;
   int    active_area_repeats = 1;
@@ -50,33 +53,29 @@ int main (int argc, char ** argv) {
   fastjet::AreaDefinition area_def = fastjet::AreaDefinition(fastjet::active_area,ghost_spec);
   fastjet::JetDefinition jet_def(antikt_algorithm, R);
 
-  double jetRapMax = 3.0;
   fastjet::Selector jet_selector = SelectorAbsRapMax(jetRapMax);
 
   //Angularity width(1.,1.,R);
   //Angularity pTD(0.,2.,R);
     
-  ProgressBar Bar(cout, nEvent);
-  Bar.SetStyle(-1);
 
-  EventMixer mixer(&cmdline);  //the mixing machinery from PU14 workshop
+  //threads of the initial-condition search of the shared layer subtraction
+  int slThreads = cmdline.value<int>("-slthreads", 1);
+
+  randomService::setSeed(cmdline.value<int>("-seed", 1));
+  EventMixer mixer(&cmdline, trw.getResumeEvents());  //the mixing machinery from PU14 workshop
+  stageTimer::enable(cmdline.present("-timing") || cmdline.present("-timingtree"), cmdline.present("-timingtree"));
 
   // loop over events
-  int iev = 0;
-  unsigned int entryDiv = (nEvent > 200) ? nEvent / 200 : 1;
-  while ( mixer.next_event() && iev < nEvent )
+  eventLoop loop(mixer, nEvent, cmdline.value<int>("-nthreads", 1));
+  loop.setCheckpoint(cmdline.value<int>("-checkpoint", 0));
+  loop.run(trw, [&](const eventData &event, treeWriter &trw)
   {
-    // increment event number    
-    iev++;
-
-    Bar.Update(iev);
-    Bar.PrintWithMod(entryDiv);
-
-    std::vector<fastjet::PseudoJet> particlesMerged = mixer.particles();
+    std::vector<fastjet::PseudoJet> particlesMerged = event.particles;
 
     std::vector<double> eventWeight;
-    eventWeight.push_back(mixer.hard_weight());
-    eventWeight.push_back(mixer.pu_weight());
+    eventWeight.push_back(event.hardWeight);
+    eventWeight.push_back(event.puWeight);
 
     // cluster hard event only
     std::vector<fastjet::PseudoJet> particlesBkg, particlesSig;
@@ -87,12 +86,15 @@ int main (int argc, char ** argv) {
     //---------------------------------------------------------------------------
     
     // run the clustering, extract the signal jets
-    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, area_def);
+    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, ghostSet::seeded(area_def));
     jetCollection jetCollectionSig(sorted_by_pt(jet_selector(csSig.inclusive_jets(10.))));
 
-    // run the clustering, extract the unsubtracted jets
-    ClusterSequenceArea csMerged(particlesMerged, jet_def, area_def);
-    jetCollection jetCollectionMerged(sorted_by_pt(jet_selector(csMerged.inclusive_jets())));
+    // run the clustering, extract the unsubtracted jets (with explicit
+    // ghosts, so the shared layer subtraction below can reuse it and its
+    // background estimate the ghosts)
+    ghostSet ghosts(ghostRapMax, ghost_area);
+    ClusterSequenceActiveAreaExplicitGhosts csMerged(particlesMerged, jet_def, ghosts.getGhosts(), ghosts.getGhostArea());
+    jetCollection jetCollectionMerged(sorted_by_pt((jet_selector && !SelectorIsPureGhost())(csMerged.inclusive_jets())));
     
     //---------------------------------------------------------------------------
     //   background subtraction
@@ -101,6 +103,12 @@ int main (int argc, char ** argv) {
     //run jet-by-jet constituent subtraction on mixed (hard+UE) event
     sharedLayerSubtractor sharedLayerSub(R,0.005,ghostRapMax,jetRapMax);
     sharedLayerSub.setInputParticles(particlesMerged);
+    sharedLayerSub.setInputJets(csMerged.inclusive_jets());
+    eventBackground background(ghostRapMax, ghost_area, jetRapMax - 0.4);
+    background.setGhosts(&ghosts);
+    background.setInputParticles(particlesMerged);
+    sharedLayerSub.setBackground(&background);
+    sharedLayerSub.setNThreads(slThreads);
     jetCollection jetCollectionSL(sharedLayerSub.doSubtraction());
 
     std::vector<double> rho;
@@ -149,20 +157,10 @@ int main (int argc, char ** argv) {
     
     trw.addCollection("eventWeight",   eventWeight);
         
-    trw.fillTree();
-
-  }//event loop
-
-  Bar.Update(nEvent);
-  Bar.Print();
-  Bar.PrintLine();
 
-  TTree *trOut = trw.getTree();
+  });//event loop
 
-  TFile *fout = new TFile("JetToyHIResultSharedLayers.root","RECREATE");
-  trOut->Write();
-  fout->Write();
-  fout->Close();
+  trw.closeFile();
 
   std::cout << "Check JetToyHIResultSharedLayers.root for results" << std::endl;
 
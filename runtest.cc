@@ -22,6 +22,7 @@
 #include "include/treeWriter.hh"
 #include "include/jetMatcher.hh"
 #include "include/randomCones.hh"
+#include "include/ghostSet.hh"
 
 using namespace std;
 using namespace fastjet;
@@ -54,6 +55,7 @@ int main (int argc, char ** argv)
   
   unsigned int mult[4] = {7000,4500,1700,100};
   double meanpt[4] = {1.2,1.0,0.9,0.85}; //for central: 1.2. peripheral: 1.
+  randomService::setSeed(cmdline.value<int>("-seed",1));
   thermalEvent thrm(mult[centBin], meanpt[centBin], -3.0, 3.0, 0.5);
   pythiaEvent pyt(120., 14, -3.0, 3.0);
 
@@ -61,9 +63,6 @@ int main (int argc, char ** argv)
   double R                   = 0.4;
   double ghostRapMax         = 6.0;
   double ghost_area          = 0.005;
-  int    active_area_repeats = 1;
-  fastjet::GhostedAreaSpec ghost_spec(ghostRapMax, active_area_repeats, ghost_area);
-  fastjet::AreaDefinition area_def = fastjet::AreaDefinition(fastjet::active_area_explicit_ghosts,ghost_spec);
   fastjet::JetDefinition jet_def(antikt_algorithm, R);
 
   double jetRapMax = 3.0;
@@ -83,6 +82,7 @@ int main (int argc, char ** argv)
     //---------------------------------------------------------------------------
     
     //create thermal event
+    randomService::beginEvent(ie);
     std::vector<fastjet::PseudoJet> particlesBkg = thrm.createThermalEvent();
     
     //create pythia event
@@ -101,13 +101,16 @@ int main (int argc, char ** argv)
     //---------------------------------------------------------------------------
     
     // run the clustering, extract the jets
-    fastjet::ClusterSequenceArea csMerged(particlesMerged, jet_def, area_def);
+    ghostSet ghosts(ghostRapMax, ghost_area);
+    fastjet::ClusterSequenceActiveAreaExplicitGhosts csMerged(particlesMerged, jet_def,
+                                                             ghosts.getGhosts(), ghosts.getGhostArea());
     jetCollection jetCollectionMerged(sorted_by_pt(jet_selector(csMerged.inclusive_jets())));
 
     // fastjet::ClusterSequenceArea csBkg(particlesBkg, jet_def, area_def);
     // jetCollection jetCollectionBkg(sorted_by_pt(csBkg.inclusive_jets()));
 
-    fastjet::ClusterSequenceArea csSig(particlesSig, jet_def, area_def);
+    fastjet::ClusterSequenceActiveAreaExplicitGhosts csSig(particlesSig, jet_def,
+                                                          ghosts.getGhosts(), ghosts.getGhostArea());
     jetCollection jetCollectionSig(sorted_by_pt(jet_selector(csSig.inclusive_jets(10.))));
 
     //---------------------------------------------------------------------------
@@ -117,7 +120,7 @@ int main (int argc, char ** argv)
     //run constituent subtraction on hybrid/embedded/merged event
     csSubtractor csSub(R, 1., -1, 0.005,ghostRapMax,jetRapMax);
     csSub.setInputParticles(particlesMerged);
-    //csSub.setInputJets(jetCollectionMerged.getJet());
+    csSub.setInputJets(csMerged.inclusive_jets());
     jetCollection jetCollectionCS(csSub.doSubtraction());
         
     std::vector<double> rho;    rho.push_back(csSub.getRho());
@@ -134,7 +137,8 @@ int main (int argc, char ** argv)
     std::vector<double> skPtThreshold;
     skPtThreshold.push_back(skSub.getPtThreshold());
 
-    fastjet::ClusterSequenceArea csSK(skEvent, jet_def, area_def);
+    fastjet::ClusterSequenceActiveAreaExplicitGhosts csSK(skEvent, jet_def,
+                                                         ghosts.getGhosts(), ghosts.getGhostArea());
     jetCollection jetCollectionSK(sorted_by_pt(jet_selector(csSK.inclusive_jets())));
 
     //std::cout << "njets CS: " << jetsCS.size() << " SK: " << jetsSK.size() << std::endl;
@@ -15,7 +15,7 @@
 #    -i  add what follows as include flags
 #    -d  add what follows as a define flag
 #    -l  add what follows as link flags
-#    -1  use c++11 flags (adds --std=c++11)
+#    -1  use c++11 flags (adds --std=c++11 -pthread)
 #    -3  force 32 bit
 #    -p  add google profiling lib
 #    -t  add google tcmalloc lib
@@ -106,8 +106,8 @@ if (defined($options{"3"})) {
 }
 
 if (defined($options{"1"})) {
-  $makefile .= "CXXFLAGS += -std=c++11\n";
-  $makefile .= "LDFLAGS += -std=c++11\n";
+  $makefile .= "CXXFLAGS += -std=c++11 -pthread\n";
+  $makefile .= "LDFLAGS += -std=c++11 -pthread\n";
 }
 
 if (defined($options{"f"})) {